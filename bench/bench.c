@@ -0,0 +1,201 @@
+/*
+ * File: bench.c
+ * -------------
+ * Description:
+ *   This program is the timing harness of the bench target of the makefile. It runs the
+ *   stages of the assembler (pre_assembly, first_pass, second_pass, create_object_file)
+ *   separately over a number of iterations and reports the accumulated time of each
+ *   stage together with the lines/sec and MB/s it sustained, so a change to one stage
+ *   can be measured without the noise of the others.
+ *
+ * Usage:
+ *   bench <file_name> [iterations]   (file_name without the .as extension)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "../src/include/general.h"
+#include "../src/include/pre_assembler.h"
+#include "../src/include/first_pass.h"
+#include "../src/include/second_pass.h"
+#include "../src/include/back_end.h"
+#include "../src/include/arena.h"
+
+#define DEFAULT_ITERATIONS 5
+
+/*
+ * Function: seconds_now
+ * ----------------------
+ * Description:
+ *   Returns the current wall clock time in seconds, with microsecond resolution.
+ */
+
+static double seconds_now(void)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (double)now.tv_sec + (double)now.tv_usec / 1000000.0;
+}
+
+/*
+ * Function: report_stage
+ * -----------------------
+ * Description:
+ *   Prints the accumulated time of one stage and the lines/sec and MB/s it sustained.
+ * Parameters:
+ *   - name: The name of the stage.
+ *   - total_seconds: The time the stage accumulated over all iterations.
+ *   - total_lines: The number of source lines the stage processed over all iterations.
+ *   - total_bytes: The number of source bytes the stage processed over all iterations.
+ */
+
+static void report_stage(char *name, double total_seconds, double total_lines, double total_bytes)
+{
+    if (total_seconds <= 0.0)
+    {
+        total_seconds = 0.000001; /*A stage faster than the clock resolution*/
+    }
+
+    printf("%-18s %10.4f s %14.0f lines/s %10.2f MB/s\n", name, total_seconds,
+           total_lines / total_seconds, total_bytes / total_seconds / (1024.0 * 1024.0));
+}
+
+int main(int argc, char **argv)
+{
+    TRANSLATION_UNIT curr_program;
+    AST_STREAM ast_stream;
+    HASH_TABLE macro_table;
+    HASH_TABLE intern_pool;
+    ARENA file_arena;
+    char *file_name;
+    char *am_file_name;
+    char *am_buffer;
+    int iterations = DEFAULT_ITERATIONS;
+    int iter;
+    int i;
+    double am_lines;
+    double am_bytes;
+    double total_lines = 0.0;
+    double total_bytes = 0.0;
+    double pre_time = 0.0;
+    double first_time = 0.0;
+    double second_time = 0.0;
+    double object_time = 0.0;
+    double stamp;
+
+    if (argc < 2 || argc > 3)
+    {
+        printf("Usage: %s <file_name> [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    file_name = argv[1];
+
+    if (argc == 3)
+    {
+        iterations = atoi(argv[2]);
+
+        if (iterations < 1)
+        {
+            printf("Error: the number of iterations must be positive\n");
+            return 1;
+        }
+    }
+
+    for (iter = 0; iter < iterations; iter++)
+    {
+        memset(&curr_program, 0, sizeof(curr_program));
+        memset(&ast_stream, 0, sizeof(ast_stream));
+        memset(&macro_table, 0, sizeof(macro_table));
+        memset(&intern_pool, 0, sizeof(intern_pool));
+        arena_init(&file_arena);
+        arena_set_current(&file_arena);
+        intern_set_current(&intern_pool);
+
+        stamp = seconds_now();
+        am_buffer = pre_assembly(file_name, &macro_table, 0);
+        pre_time += seconds_now() - stamp;
+
+        if (am_buffer == NULL)
+        {
+            printf("Error: pre assembly of %s failed, the input is not a clean benchmark file\n", file_name);
+            arena_set_current(NULL);
+            arena_release(&file_arena);
+            return 1;
+        }
+
+        /*The expanded source is what the passes actually consume, so it is the
+          size that lines/sec and MB/s are measured against*/
+        am_bytes = (double)strlen(am_buffer);
+        am_lines = 0.0;
+
+        for (i = 0; am_buffer[i] != '\0'; i++)
+        {
+            if (am_buffer[i] == '\n')
+            {
+                am_lines += 1.0;
+            }
+        }
+
+        total_lines += am_lines;
+        total_bytes += am_bytes;
+
+        am_file_name = dynamic_strcat(file_name, ".am");
+
+        stamp = seconds_now();
+
+        if (first_pass(&curr_program, am_buffer, am_file_name, &macro_table, &ast_stream) != NO_ERRORS)
+        {
+            printf("Error: first pass of %s failed\n", file_name);
+            return 1;
+        }
+
+        first_time += seconds_now() - stamp;
+
+        stamp = seconds_now();
+
+        if (second_pass(&curr_program, am_file_name, &ast_stream) != NO_ERRORS)
+        {
+            printf("Error: second pass of %s failed\n", file_name);
+            return 1;
+        }
+
+        second_time += seconds_now() - stamp;
+
+        stamp = seconds_now();
+
+        if (create_object_file(&curr_program, file_name) == MEMORY_ALLOCATION_ERROR)
+        {
+            printf("Error: object file creation of %s failed\n", file_name);
+            return 1;
+        }
+
+        object_time += seconds_now() - stamp;
+
+        free(am_buffer);
+        free_ext_refs(&curr_program);
+        free_symbol_table(&curr_program.symbol_table);
+        free_entries(&curr_program);
+        free_ast_stream(&ast_stream);
+        free_macro_table(&macro_table);
+        free_memory_image(&curr_program.instruction_image);
+        free_memory_image(&curr_program.data_image);
+        free_hash_table(&intern_pool);
+        intern_set_current(NULL);
+        arena_set_current(NULL);
+        arena_release(&file_arena);
+    }
+
+    printf("bench: %s , %d iterations , %.0f expanded lines per iteration\n",
+           file_name, iterations, total_lines / iterations);
+    report_stage("pre_assembly", pre_time, total_lines, total_bytes);
+    report_stage("first_pass", first_time, total_lines, total_bytes);
+    report_stage("second_pass", second_time, total_lines, total_bytes);
+    report_stage("create_object_file", object_time, total_lines, total_bytes);
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * File: gen_bench.c
+ * -----------------
+ * Description:
+ *   This program synthesizes large .as inputs for the bench target of the makefile.
+ *   The shape argument controls which part of the assembler the input stresses:
+ *   macro  - a few multi-line macros called over and over (pre-assembly heavy).
+ *   label  - thousands of label definitions and references (symbol table heavy).
+ *   data   - long .data and .string directives (data image heavy).
+ *   extern - a handful of externals referenced many times (external index heavy).
+ *
+ * Usage:
+ *   gen_bench <output.as> <macro|label|data|extern> <lines>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MACRO_COUNT 8 /*Number of macros defined by the macro shape*/
+#define BENCH_MACRO_BODY 8  /*Number of lines in the body of each macro*/
+#define BENCH_EXTERN_COUNT 8
+
+/*
+ * Function: generate_macro_heavy
+ * -------------------------------
+ * Description:
+ *   Writes a few multi-line macro definitions followed by a long run of macro calls,
+ *   so nearly all the work of the file is macro expansion.
+ */
+
+static void generate_macro_heavy(FILE *out, int lines)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < BENCH_MACRO_COUNT; i++)
+    {
+        fprintf(out, "mcr m%d\n", i);
+
+        for (j = 0; j < BENCH_MACRO_BODY; j++)
+        {
+            fprintf(out, "\tmov r%d, r%d\n", j % 8, (j + 1) % 8);
+        }
+
+        fprintf(out, "endmcr\n");
+    }
+
+    for (i = 0; i < lines; i++)
+    {
+        fprintf(out, "m%d\n", i % BENCH_MACRO_COUNT);
+    }
+
+    fprintf(out, "\thlt\n");
+}
+
+/*
+ * Function: generate_label_heavy
+ * -------------------------------
+ * Description:
+ *   Writes thousands of label definitions, each referenced by a later jump, so the
+ *   symbol table takes both a definition and a lookup per generated pair.
+ */
+
+static void generate_label_heavy(FILE *out, int lines)
+{
+    int i;
+
+    for (i = 0; i < lines / 2; i++)
+    {
+        fprintf(out, "LBL%d:\tmov r1, r2\n", i);
+    }
+
+    for (i = 0; i < lines / 2; i++)
+    {
+        fprintf(out, "\tjmp LBL%d\n", i);
+    }
+
+    fprintf(out, "\thlt\n");
+}
+
+/*
+ * Function: generate_data_heavy
+ * ------------------------------
+ * Description:
+ *   Writes long runs of .data and .string directives, so most of the time is spent
+ *   encoding the data image.
+ */
+
+static void generate_data_heavy(FILE *out, int lines)
+{
+    int i;
+
+    fprintf(out, "MAIN:\thlt\n");
+
+    for (i = 0; i < lines; i++)
+    {
+        if (i % 4 == 3)
+        {
+            fprintf(out, "S%d: .string \"abcdefghijklmnop\"\n", i);
+        }
+
+        else
+        {
+            fprintf(out, "D%d: .data %d, %d, %d, %d, %d, %d\n", i, i % 100, -(i % 50), i % 7, 42, -(i % 9), i % 11);
+        }
+    }
+}
+
+/*
+ * Function: generate_extern_heavy
+ * --------------------------------
+ * Description:
+ *   Writes a handful of .extern declarations followed by a long run of references to
+ *   them, so the external index records many addresses for few symbols.
+ */
+
+static void generate_extern_heavy(FILE *out, int lines)
+{
+    int i;
+
+    for (i = 0; i < BENCH_EXTERN_COUNT; i++)
+    {
+        fprintf(out, ".extern EXT%d\n", i);
+    }
+
+    for (i = 0; i < lines; i++)
+    {
+        fprintf(out, "\tjsr EXT%d\n", i % BENCH_EXTERN_COUNT);
+    }
+
+    fprintf(out, "\thlt\n");
+}
+
+int main(int argc, char **argv)
+{
+    FILE *out;
+    int lines;
+
+    if (argc != 4)
+    {
+        printf("Usage: %s <output.as> <macro|label|data|extern> <lines>\n", argv[0]);
+        return 1;
+    }
+
+    lines = atoi(argv[3]);
+
+    if (lines < 1)
+    {
+        printf("Error: the number of lines must be positive\n");
+        return 1;
+    }
+
+    out = fopen(argv[1], "w");
+
+    if (out == NULL)
+    {
+        printf("Error the file : %s , cannot be opened\n", argv[1]);
+        return 1;
+    }
+
+    if (strcmp(argv[2], "macro") == 0)
+    {
+        generate_macro_heavy(out, lines);
+    }
+
+    else if (strcmp(argv[2], "label") == 0)
+    {
+        generate_label_heavy(out, lines);
+    }
+
+    else if (strcmp(argv[2], "data") == 0)
+    {
+        generate_data_heavy(out, lines);
+    }
+
+    else if (strcmp(argv[2], "extern") == 0)
+    {
+        generate_extern_heavy(out, lines);
+    }
+
+    else
+    {
+        printf("Error: unknown shape %s\n", argv[2]);
+        fclose(out);
+        return 1;
+    }
+
+    fclose(out);
+    return 0;
+}
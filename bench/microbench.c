@@ -0,0 +1,444 @@
+/*
+ * File: microbench.c
+ * ------------------
+ * Description:
+ *   This program is the function-level timing harness of the microbench target of the
+ *   makefile. The end-to-end bench target measures whole stages, but the inner loop of
+ *   the assembler is a handful of front-end helpers (get_word, is_valid_num, is_label,
+ *   is_label_with_index and check_inst_operand) whose cost disappears inside the stage
+ *   totals. Each helper is driven here over small representative corpora (register
+ *   operands, indexed labels and .data number lists) and its ns/op and ops/sec are
+ *   reported, so a parser change can be evaluated without the noise of the full
+ *   pipeline. Hardware counters such as branch misses are gathered by running one
+ *   function under an external profiler, for example:
+ *
+ *     perf stat -e branches,branch-misses ./bench_micro get_word
+ *
+ *   which is why a single function can be selected on the command line.
+ *
+ * Usage:
+ *   bench_micro [function] [operations]
+ *   function is one of get_word, is_valid_num, is_label, is_label_with_index,
+ *   check_inst_operand or all (the default); operations is the number of calls
+ *   to time per corpus (default 1000000).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "../src/include/general.h"
+#include "../src/include/front_end.h"
+#include "../src/include/arena.h"
+
+#define DEFAULT_OPERATIONS 1000000
+#define CORPUS_SIZE 64      /*Number of lines or words per corpus*/
+#define CORPUS_WORD_LEN 48  /*Size of one corpus entry, enough for the longest line below*/
+
+/*The label position constants of is_label are a private enum of front_end.c
+  (pre_line_label, operand_label); every call here checks an operand word*/
+#define OPERAND_LABEL_POSITION 1
+
+/*A sink the timed results are folded into, so no call can be considered dead*/
+static long result_sink = 0;
+
+/*
+ * Function: reset_memory
+ * -----------------------
+ * Description:
+ *   Releases the arena and the intern pool between two timed functions and installs
+ *   fresh ones, the way the assembler does between two files. The timed helpers copy
+ *   words and intern names into the arena, so without the reset the whole run would
+ *   accumulate in memory.
+ * Parameters:
+ *   - bench_arena: The arena serving the timed calls.
+ *   - intern_pool: The intern pool serving the timed calls.
+ */
+
+static void reset_memory(ARENA *bench_arena, HASH_TABLE *intern_pool)
+{
+    intern_set_current(NULL);
+    arena_set_current(NULL);
+    arena_release(bench_arena);
+    free_hash_table(intern_pool);
+
+    memset(intern_pool, 0, sizeof(*intern_pool));
+    arena_init(bench_arena);
+    arena_set_current(bench_arena);
+    intern_set_current(intern_pool);
+}
+
+/*
+ * Function: seconds_now
+ * ----------------------
+ * Description:
+ *   Returns the current wall clock time in seconds, with microsecond resolution.
+ */
+
+static double seconds_now(void)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (double)now.tv_sec + (double)now.tv_usec / 1000000.0;
+}
+
+/*
+ * Function: report_function
+ * --------------------------
+ * Description:
+ *   Prints the measured cost of one function over one corpus.
+ * Parameters:
+ *   - name: The name of the function and the corpus it ran over.
+ *   - total_seconds: The time the calls accumulated.
+ *   - operations: The number of calls that were timed.
+ */
+
+static void report_function(char *name, double total_seconds, long operations)
+{
+    if (total_seconds <= 0.0)
+    {
+        total_seconds = 0.000001; /*Faster than the clock resolution*/
+    }
+
+    printf("%-32s %10.1f ns/op %14.0f ops/s\n", name,
+           total_seconds / (double)operations * 1000000000.0,
+           (double)operations / total_seconds);
+}
+
+/*
+ * Function: build_corpora
+ * ------------------------
+ * Description:
+ *   Fills the three corpora with representative text. The numbers rotate so the hashed
+ *   helpers see many distinct names instead of one hot slot, like real source does.
+ * Parameters:
+ *   - register_lines: Receives operand text of register-to-register instructions.
+ *   - indexed_lines: Receives operand text with an indexed label source operand.
+ *   - data_lines: Receives .data style comma-separated number lists.
+ */
+
+static void build_corpora(char register_lines[][CORPUS_WORD_LEN],
+                          char indexed_lines[][CORPUS_WORD_LEN],
+                          char data_lines[][CORPUS_WORD_LEN])
+{
+    int i;
+
+    for (i = 0; i < CORPUS_SIZE; i++)
+    {
+        sprintf(register_lines[i], "r%d, r%d", i % 8, (i + 3) % 8);
+        sprintf(indexed_lines[i], "LAB%d[SIZ%d], r%d", i, i % 4, i % 8);
+        sprintf(data_lines[i], "%d, %d, %d, %d", i * 7 - 100, i, -i, 2000 - i * 9);
+    }
+}
+
+/*
+ * Function: bench_get_word
+ * -------------------------
+ * Description:
+ *   Times get_word by tokenizing the lines of one corpus over and over. Every call is
+ *   one timed operation, so the cost covers the separator skipping, the word scan and
+ *   the arena copy exactly as the parser pays them.
+ * Parameters:
+ *   - name: The report label, naming the corpus shape.
+ *   - corpus: The lines to tokenize.
+ *   - operations: The number of calls to time.
+ */
+
+static void bench_get_word(char *name, char corpus[][CORPUS_WORD_LEN], long operations)
+{
+    char *cursor;
+    char *word;
+    long ops = 0;
+    int i;
+    double stamp;
+
+    stamp = seconds_now();
+
+    while (ops < operations)
+    {
+        for (i = 0; i < CORPUS_SIZE; i++)
+        {
+            cursor = corpus[i];
+
+            while ((word = get_word(&cursor)) != NULL)
+            {
+                result_sink += word[0];
+                ops++;
+            }
+        }
+    }
+
+    report_function(name, seconds_now() - stamp, ops);
+}
+
+/*
+ * Function: bench_is_valid_num
+ * -----------------------------
+ * Description:
+ *   Times is_valid_num over a mix of valid numbers, out-of-range numbers and names,
+ *   so both the accepting and the rejecting paths are covered.
+ * Parameters:
+ *   - operations: The number of calls to time.
+ */
+
+static void bench_is_valid_num(long operations)
+{
+    char words[CORPUS_SIZE][CORPUS_WORD_LEN];
+    long ops = 0;
+    int i;
+    double stamp;
+
+    for (i = 0; i < CORPUS_SIZE; i++)
+    {
+        if (i % 4 == 3)
+        {
+            sprintf(words[i], "SIZ%d", i); /*A constant name, the rejecting path*/
+        }
+
+        else
+        {
+            sprintf(words[i], "%d", (i * 131) % 4000 - 2000); /*Some beyond 12 bits*/
+        }
+    }
+
+    stamp = seconds_now();
+
+    while (ops < operations)
+    {
+        for (i = 0; i < CORPUS_SIZE; i++)
+        {
+            result_sink += is_valid_num(words[i]);
+            ops++;
+        }
+    }
+
+    report_function("is_valid_num/data", seconds_now() - stamp, ops);
+}
+
+/*
+ * Function: bench_is_label
+ * -------------------------
+ * Description:
+ *   Times is_label over operand words: plain labels, register names (rejected as
+ *   reserved) and numbers (rejected at the first character).
+ * Parameters:
+ *   - operations: The number of calls to time.
+ */
+
+static void bench_is_label(long operations)
+{
+    char words[CORPUS_SIZE][CORPUS_WORD_LEN];
+    long ops = 0;
+    int i;
+    double stamp;
+
+    for (i = 0; i < CORPUS_SIZE; i++)
+    {
+        if (i % 4 == 3)
+        {
+            sprintf(words[i], "r%d", i % 8);
+        }
+
+        else
+        {
+            sprintf(words[i], "LOOP%d", i);
+        }
+    }
+
+    stamp = seconds_now();
+
+    while (ops < operations)
+    {
+        for (i = 0; i < CORPUS_SIZE; i++)
+        {
+            result_sink += is_label(words[i], OPERAND_LABEL_POSITION);
+            ops++;
+        }
+    }
+
+    report_function("is_label/register", seconds_now() - stamp, ops);
+}
+
+/*
+ * Function: bench_is_label_with_index
+ * ------------------------------------
+ * Description:
+ *   Times is_label_with_index over indexed operands with both numeric and constant
+ *   indices, covering the bracket splitting, the label checks and the interning.
+ * Parameters:
+ *   - operations: The number of calls to time.
+ */
+
+static void bench_is_label_with_index(long operations)
+{
+    char words[CORPUS_SIZE][CORPUS_WORD_LEN];
+    INST_OPERAND operand;
+    long ops = 0;
+    int i;
+    double stamp;
+
+    for (i = 0; i < CORPUS_SIZE; i++)
+    {
+        if (i % 2 == 0)
+        {
+            sprintf(words[i], "LAB%d[%d]", i, i % 10);
+        }
+
+        else
+        {
+            sprintf(words[i], "LAB%d[SIZ%d]", i, i % 4);
+        }
+    }
+
+    stamp = seconds_now();
+
+    while (ops < operations)
+    {
+        for (i = 0; i < CORPUS_SIZE; i++)
+        {
+            result_sink += is_label_with_index(words[i], &operand);
+            ops++;
+        }
+    }
+
+    report_function("is_label_with_index/indexed", seconds_now() - stamp, ops);
+}
+
+/*
+ * Function: bench_check_inst_operand
+ * -----------------------------------
+ * Description:
+ *   Times check_inst_operand parsing the operand text of mov instructions over one
+ *   corpus, covering the whole operand loop: tokenizing, the comma handling and the
+ *   number, label, indexed label and register classification.
+ * Parameters:
+ *   - name: The report label, naming the corpus shape.
+ *   - corpus: The operand text to parse (everything after the opcode word).
+ *   - operations: The number of calls to time.
+ */
+
+static void bench_check_inst_operand(char *name, char corpus[][CORPUS_WORD_LEN], long operations)
+{
+    LINE_AST ast;
+    char *cursor;
+    long ops = 0;
+    int i;
+    double stamp;
+
+    memset(&ast, 0, sizeof(ast));
+    ast.type = inst;
+    ast.operand.instruction.type = mov;
+
+    stamp = seconds_now();
+
+    while (ops < operations)
+    {
+        for (i = 0; i < CORPUS_SIZE; i++)
+        {
+            cursor = corpus[i];
+            ast.error_detail = NULL;
+            result_sink += check_inst_operand(&cursor, &ast);
+            ops++;
+        }
+    }
+
+    report_function(name, seconds_now() - stamp, ops);
+}
+
+int main(int argc, char **argv)
+{
+    HASH_TABLE intern_pool;
+    ARENA bench_arena;
+    char register_lines[CORPUS_SIZE][CORPUS_WORD_LEN];
+    char indexed_lines[CORPUS_SIZE][CORPUS_WORD_LEN];
+    char data_lines[CORPUS_SIZE][CORPUS_WORD_LEN];
+    char *selected = "all";
+    long operations = DEFAULT_OPERATIONS;
+    int matched = 0;
+
+    if (argc > 3)
+    {
+        printf("Usage: %s [function] [operations]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc >= 2)
+    {
+        selected = argv[1];
+    }
+
+    if (argc == 3)
+    {
+        operations = atol(argv[2]);
+
+        if (operations < 1)
+        {
+            printf("Error: the number of operations must be positive\n");
+            return 1;
+        }
+    }
+
+    build_corpora(register_lines, indexed_lines, data_lines);
+
+    /*The timed helpers copy words and intern names exactly like the parser, so they
+      need the arena and the intern pool the parser runs with*/
+    memset(&intern_pool, 0, sizeof(intern_pool));
+    arena_init(&bench_arena);
+    arena_set_current(&bench_arena);
+    intern_set_current(&intern_pool);
+
+    if (strcmp(selected, "all") == 0 || strcmp(selected, "get_word") == 0)
+    {
+        bench_get_word("get_word/register", register_lines, operations);
+        reset_memory(&bench_arena, &intern_pool);
+        bench_get_word("get_word/indexed", indexed_lines, operations);
+        reset_memory(&bench_arena, &intern_pool);
+        bench_get_word("get_word/data", data_lines, operations);
+        reset_memory(&bench_arena, &intern_pool);
+        matched = 1;
+    }
+
+    if (strcmp(selected, "all") == 0 || strcmp(selected, "is_valid_num") == 0)
+    {
+        bench_is_valid_num(operations);
+        matched = 1;
+    }
+
+    if (strcmp(selected, "all") == 0 || strcmp(selected, "is_label") == 0)
+    {
+        bench_is_label(operations);
+        matched = 1;
+    }
+
+    if (strcmp(selected, "all") == 0 || strcmp(selected, "is_label_with_index") == 0)
+    {
+        bench_is_label_with_index(operations);
+        reset_memory(&bench_arena, &intern_pool);
+        matched = 1;
+    }
+
+    if (strcmp(selected, "all") == 0 || strcmp(selected, "check_inst_operand") == 0)
+    {
+        bench_check_inst_operand("check_inst_operand/register", register_lines, operations);
+        reset_memory(&bench_arena, &intern_pool);
+        bench_check_inst_operand("check_inst_operand/indexed", indexed_lines, operations);
+        matched = 1;
+    }
+
+    intern_set_current(NULL);
+    arena_set_current(NULL);
+    arena_release(&bench_arena);
+    free_hash_table(&intern_pool);
+
+    if (matched == 0)
+    {
+        printf("Error: unknown function %s , use get_word, is_valid_num, is_label, is_label_with_index, check_inst_operand or all\n", selected);
+        return 1;
+    }
+
+    /*Report the sink so the timed calls stay observable*/
+    printf("microbench: done , checksum %ld\n", result_sink);
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "include/front_end.h"
 #include "include/general.h"
@@ -8,162 +9,687 @@
 #include "include/first_pass.h"
 #include "include/second_pass.h"
 #include "include/back_end.h"
+#include "include/arena.h"
+#include "include/profile.h"
+#include "include/cache.h"
+#include "include/pipeline.h"
+#include "include/writer_thread.h"
+#include "include/diag.h"
+
+#define MAX_WORKERS 64 /*Upper bound for the -j option, to keep a bad argument from spawning thousands of threads*/
+#define SERVER_REQUEST_LEN 4096 /*Longest file path one server request may carry, including the newline*/
+
+/*Shared state of the worker pool: the list of input files and the index of the next file to assemble.
+  Workers take the next index under the lock, so every file is processed exactly once.*/
+typedef struct WORKER_POOL
+{
+    char **argv;
+    int argc;
+    int next_arg;
+    int keep_am_flag;
+    int pipeline_flag;
+    int single_pass_flag;
+    int binary_obj_flag;
+    char *cache_dir;
+    pthread_mutex_t lock;
+} WORKER_POOL;
 
 /*
- * Main Function - Assembler Program
- *
+ * Function: process_file
+ * -----------------------
  * Description:
- *   The main function orchestrates the entire process of assembling assembly files.
- *   It iterates over each file passed through the command line and performs these steps:
- *   pre-assembling, first pass, second pass, and back-end.
- *   Memory allocation errors are handled by freeing allocated memory and continuing to the next file.
- *
- * The assumption is that the files do not require more than 3996 memory cells in order to encode them.
- *
+ *   Assembles a single input file: pre-assembling, first pass, second pass and back-end.
+ *   Memory allocation errors are handled by freeing allocated memory and returning, so the
+ *   caller can continue to the next file.
  *
  * Parameters:
- *   argc: An integer representing the number of command-line arguments.
- *   argv: An array of strings containing the command-line arguments.
- *
- * Return Value: 1
- *
+ *   file_name: The name of the input file, without the .as extension.
+ *   keep_am_flag: When different from 0, the pre-assembler also writes the expanded source to a .am file.
+ *   cache_dir: Path of the incremental cache directory, or NULL when --cache-dir was not given.
+ *              When the content key of the expanded source matches a cache entry, the passes are
+ *              skipped and the previously emitted outputs are restored from the cache.
+ *   pipeline_flag: When different from 0, macro expansion runs on a producer thread while this
+ *                  thread parses the expanded lines, overlapping the two phases (--pipeline).
+ *   single_pass_flag: When different from 0, the file is assembled in one traversal with
+ *                     backpatching (--single-pass) instead of the two passes.
+ *   binary_obj_flag: When different from 0, the object file is written in the binary format
+ *                    of --obj-format=binary instead of the default text format.
  *
  * Operation:
- *   - The function initializes variables and data structures needed for processing.
- *   - It iterates over each input file received through the command line and make these steps:
  *   - Pre-assembling:
  *                     - Check errors in the macros definition and that no line in the file containing more than 80 characters.
- *                     - If there are no errors, a file with the extension am is created that containing the contents of the file after placing the macro.
+ *                     - If there are no errors, an in-memory buffer containing the contents of the file after placing the macro is created
+ *                       (a file with the extension am is also written when the --keep-am option is given).
  *                     - If there are errors the program will not proceed to the next steps for the current file.
- *                     - Rather, it will release the allocated memory and continue to the next file received on the command line.
  *   - first pass:
- *                     - Go over the am file and detect syntax errors in the text.
+ *                     - Go over the expanded source and detect syntax errors in the text.
  *                     - Additionally creates the symbol table, and a list containing the entry symbols in the program.
  *   - Second pass:
  *                     - If there are no errors in the first pass, the program continues to the second pass.
- *                     - At this step, the program go over the am file again and detect logical errors as well as encode  the assembly code into binary code.
+ *                     - At this step, the program go over the parsed lines again and detect logical errors as well as encode  the assembly code into binary code.
  *   - Back end :
  *                     - If there were no errors in the previous steps, the program continues to this step.
- *                     - it creates object files and additional files (entries, externs) if needed.
+ *                     - The output work (the object file and the additional entries and externs files
+ *                       if needed) is handed to the background writer thread, which flushes the files
+ *                       while the next file is assembled.
  *
- *   - At the end of each iteration, the program releases the allocated dynamic memory and closes the relevant files.
+ *   - At the end, the function releases the dynamic memory that was allocated for the file;
+ *     the memory a handed-off job still needs is released by the writer after the flush.
+ *
+ * Returns:
+ *   - NO_ERRORS when the file assembled (or was restored from the cache), otherwise the
+ *     status of the failing stage. The server mode reports it to the client; the batch
+ *     modes ignore it, since every error was already printed.
  */
 
-int main(int argc, char **argv)
+static int process_file(char *file_name, int keep_am_flag, char *cache_dir, int pipeline_flag, int single_pass_flag, int binary_obj_flag)
 {
-    int i;
     char *am_file_name;
-    FILE *am_file;
+    char *am_buffer;
     TRANSLATION_UNIT curr_program;
-    MACRO *macro_table[HASH_TABLE_SIZE] = {0};
+    AST_STREAM ast_stream;
+    HASH_TABLE macro_table;
+    HASH_TABLE intern_pool;
     int first_pass_error_flag, second_pass_error_flag;
+    ARENA file_arena;
+    ARENA producer_arena;
+    char content_key[CACHE_KEY_LEN];
+    OUTPUT_JOB output_job;
+    DIAG diag;
+    int cache_hit = 0;
+    int handed_off = 0;
+    int status = NO_ERRORS;
+    double stage_stamp = 0.0;
+    double pre_seconds = 0.0, first_seconds = 0.0, second_seconds = 0.0;
 
-    for (i = 1; i < argc; i++)
+    memset(&curr_program, 0, sizeof(curr_program));
+    memset(&ast_stream, 0, sizeof(ast_stream));
+    memset(&macro_table, 0, sizeof(macro_table));
+    memset(&intern_pool, 0, sizeof(intern_pool));
+
+    /*The diagnostics of the file are accumulated in this sink and flushed in one write
+      below, instead of one console write per error*/
+    diag_open(&diag);
+
+    /*All the small allocations of this file (tokens, table nodes, macro bodies) are drawn
+      from one arena and released together at the end of the file*/
+    arena_init(&file_arena);
+    arena_set_current(&file_arena);
+
+    /*Every label and constant name of the file is stored once in this pool, so the
+      passes compare names by pointer*/
+    intern_set_current(&intern_pool);
+
+    if (profile_enabled)
+    {
+        stage_stamp = profile_seconds_now();
+    }
+
+    /*pre_assembley process - expand the macros into an in-memory buffer, if an error occured it returns NULL.
+      In the pipeline mode the expansion runs on a producer thread while this thread parses the lines*/
+    if (pipeline_flag)
+    {
+        arena_init(&producer_arena);
+        am_buffer = pipelined_pre_assembly(file_name, &macro_table, keep_am_flag, &ast_stream, &producer_arena);
+    }
+
+    else
     {
-        memset(&curr_program, 0, sizeof(curr_program));
+        am_buffer = pre_assembly(file_name, &macro_table, keep_am_flag);
+    }
 
-        /*pre_assembley process  - create a file after opening the macros (am file) ,if an error occured it remove the am file */
-        am_file_name = pre_assembly(argv[i], macro_table);
+    if (profile_enabled)
+    {
+        pre_seconds = profile_seconds_now() - stage_stamp;
+    }
 
-        /*If there is an error in the pre-abmsley process (meaning that The am_file_name == NULL),  the program moves to the next file received by the command line*/
-        if (am_file_name)
+    /*If there is an error in the pre-abmsley process (meaning that The am_buffer == NULL), the file is skipped*/
+    if (am_buffer)
+    {
+        /*The key covers the macro-expanded source, so it changes whenever the .as file or
+          any macro it pulls in changes. On a hit the passes are skipped entirely*/
+        if (cache_dir != NULL)
         {
+            cache_key(am_buffer, content_key);
 
-            am_file = fopen(am_file_name, "r");
-            if (am_file)
+            /*The two object formats must not share a cache entry; 'B' is not a hex
+              digit, so the tagged key never collides with a text key*/
+            if (binary_obj_flag)
             {
+                content_key[0] = 'B';
+            }
 
-                first_pass_error_flag = first_pass(&curr_program, am_file, am_file_name, macro_table);
+            cache_hit = cache_restore(cache_dir, content_key, file_name);
+        }
 
-                if (first_pass_error_flag == MEMORY_ALLOCATION_ERROR)
+        if (cache_hit == 0)
+        {
+            /*The am file name is still used to report the location of errors found by the passes*/
+            am_file_name = dynamic_strcat(file_name, ".am");
+
+            if (am_file_name)
+            {
+
+                if (profile_enabled)
+                {
+                    stage_stamp = profile_seconds_now();
+                }
+
+                /*In the pipeline mode the lines were already parsed while the macros expanded,
+                  so only the symbol table work of the first pass remains*/
+                if (pipeline_flag)
+                {
+                    first_pass_error_flag = first_pass_from_stream(&curr_program, am_file_name, &macro_table, &ast_stream);
+                }
+
+                /*In the single-pass mode the lines are encoded while the symbols are
+                  collected, so the status covers both passes*/
+                else if (single_pass_flag)
+                {
+                    first_pass_error_flag = single_pass(&curr_program, am_buffer, am_file_name, &macro_table);
+                }
+
+                else
+                {
+                    first_pass_error_flag = first_pass(&curr_program, am_buffer, am_file_name, &macro_table, &ast_stream);
+                }
+
+                if (profile_enabled)
                 {
-                    /* free all the memory in the program and continue to next file */
-                    free_symbol_table(curr_program.symbol_table);
-                    free_entries_list(curr_program.entries_list);
-                    free_macro_table(macro_table);
-                    free(am_file_name);
-                    fclose(am_file);
-                    continue;
+                    first_seconds = profile_seconds_now() - stage_stamp;
                 }
 
-                else if (first_pass_error_flag == NO_ERRORS)
+                status = first_pass_error_flag;
+
+                if (first_pass_error_flag == NO_ERRORS)
                 {
-                    rewind(am_file);
-                    second_pass_error_flag = second_pass(&curr_program, am_file_name, am_file);
+                    if (profile_enabled)
+                    {
+                        stage_stamp = profile_seconds_now();
+                    }
+
+                    /*The single-pass mode already encoded and patched everything*/
+                    second_pass_error_flag = single_pass_flag ? NO_ERRORS
+                                                              : second_pass(&curr_program, am_file_name, &ast_stream);
 
-                    if (second_pass_error_flag == MEMORY_ALLOCATION_ERROR)
+                    if (profile_enabled)
                     {
-                        /* free all the memory in the program and continue to next file */
-                        free_symbol_table(curr_program.symbol_table);
-                        free_entries_list(curr_program.entries_list);
-                        free_ext_list(&curr_program.ext_list);
-                        free_macro_table(macro_table);
-                        free(am_file_name);
-                        fclose(am_file);
-                        continue;
+                        second_seconds = profile_seconds_now() - stage_stamp;
                     }
 
-                    else if (second_pass_error_flag == NO_ERRORS)
+                    status = second_pass_error_flag;
+
+                    if (second_pass_error_flag == NO_ERRORS)
                     {
-                        /*create the object file, using the translation unit */
+                        /*Pack the output work for the background writer thread, so the
+                          .ob, .ent and .ext files are flushed while the next file is
+                          assembled. The job takes ownership of the images, the entry
+                          and external vectors and the per-file arena (the names they
+                          point to live in it), so none of them are freed below. The
+                          job is submitted only after the cleanup, because the tables
+                          torn down there walk nodes living in that same arena*/
+                        output_job.unit = curr_program;
+                        output_job.file_name = file_name;
+                        output_job.binary_obj_flag = binary_obj_flag;
+                        output_job.cache_dir = cache_dir;
+                        output_job.arena = file_arena;
+                        output_job.pre_seconds = pre_seconds;
+                        output_job.first_seconds = first_seconds;
+                        output_job.second_seconds = second_seconds;
+                        output_job.symbol_lookups = curr_program.symbol_table.lookups;
+                        output_job.symbol_probes = curr_program.symbol_table.probes;
+                        output_job.macro_lookups = macro_table.lookups;
+                        output_job.macro_probes = macro_table.probes;
 
-                        if (create_object_file(&curr_program, argv[i]) == MEMORY_ALLOCATION_ERROR)
+                        if (cache_dir != NULL)
                         {
-                            /* free all the memory in the program and continue to next file */
-                            free_symbol_table(curr_program.symbol_table);
-                            free_entries_list(curr_program.entries_list);
-                            free_ext_list(&curr_program.ext_list);
-                            free_macro_table(macro_table);
-                            free(am_file_name);
-                            fclose(am_file);
-                            continue;
+                            memcpy(output_job.content_key, content_key, CACHE_KEY_LEN);
                         }
 
-                        else /*There is no memory or file opening error in the creation of the ob file */
-                        {
-                            if (curr_program.entries_counter > 0)
-                            {
-                                if (create_entries_file(&curr_program, argv[i]) == MEMORY_ALLOCATION_ERROR)
-                                {
-                                    /* free all the memory in the program and continue to next file */
-                                    free_symbol_table(curr_program.symbol_table);
-                                    free_entries_list(curr_program.entries_list);
-                                    free_ext_list(&curr_program.ext_list);
-                                    free_macro_table(macro_table);
-                                    free(am_file_name);
-                                    fclose(am_file);
-                                    continue;
-                                }
-                            }
-
-                            if (curr_program.external_counter > 0)
-                            {
-                                if (create_external_file(&curr_program, argv[i]) == MEMORY_ALLOCATION_ERROR)
-                                {
-                                    /* free all the memory in the program and continue to next file */
-                                    free_symbol_table(curr_program.symbol_table);
-                                    free_entries_list(curr_program.entries_list);
-                                    free_ext_list(&curr_program.ext_list);
-                                    free_macro_table(macro_table);
-                                    free(am_file_name);
-                                    fclose(am_file);
-                                    continue;
-                                }
-                            }
-                        }
+                        handed_off = 1;
                     }
                 }
 
-                free_ext_list(&curr_program.ext_list);
-                free_symbol_table(curr_program.symbol_table);
-                free_entries_list(curr_program.entries_list);
             }
 
-            free(am_file_name);
-            fclose(am_file);
+            else
+            {
+                diag_error("Error in file : %s , memory allocation failed\n", file_name);
+                status = MEMORY_ALLOCATION_ERROR;
+            }
+
+        }
+
+        free(am_buffer);
+    }
+
+    else
+    {
+        /*The pre-assembler already printed what went wrong*/
+        status = SYNTAX_OR_LOGIC_ERROR;
+    }
+
+    diag_flush(&diag);
+
+    /*For a handed-off file the writer records the profile line, with the back-end time
+      it measures itself; the probe counters were scraped into the job before this point*/
+    if (profile_enabled && handed_off == 0)
+    {
+        profile_record_file(file_name, pre_seconds, first_seconds, second_seconds, 0.0,
+                            curr_program.symbol_table.lookups, curr_program.symbol_table.probes,
+                            macro_table.lookups, macro_table.probes);
+    }
+
+    /* free all the memory that was allocated for the current file; the vectors, the
+       images and the arena of a handed-off file are released by the writer thread */
+    if (handed_off == 0)
+    {
+        free_ext_refs(&curr_program);
+        free_entries(&curr_program);
+        free_memory_image(&curr_program.instruction_image);
+        free_memory_image(&curr_program.data_image);
+    }
+
+    free_symbol_table(&curr_program.symbol_table);
+    free_ast_stream(&ast_stream);
+    free_macro_table(&macro_table);
+    free_hash_table(&intern_pool);
+
+    /*Release every per-file allocation in one shot; the interned names live in the arena*/
+    intern_set_current(NULL);
+    arena_set_current(NULL);
+
+    /*The macro table, the symbol table, the stream and the intern pool above all walk
+      nodes living in the file arena, so the job (which owns the arena) is handed off
+      only now; submitting earlier would let the writer release the arena while the
+      tables are still being walked*/
+    if (handed_off)
+    {
+        writer_thread_submit(&output_job);
+    }
+
+    else
+    {
+        arena_release(&file_arena);
+    }
+
+    /*The macro bodies and tokens of the producer thread live in its own arena*/
+    if (pipeline_flag)
+    {
+        arena_release(&producer_arena);
+    }
+
+    return status;
+}
+
+/*
+ * Function: server_loop
+ * ----------------------
+ * Description:
+ *   Runs the resident server of the --server mode. Build systems and editor
+ *   integrations that invoke the assembler once per file pay the process spawn and
+ *   teardown for inputs that assemble in microseconds; in the server mode the process
+ *   stays resident and assembles one file per request instead. A request is one line on
+ *   the standard input holding a file path (without the .as extension, like a command
+ *   line argument); the file is assembled with the options of the command line, the
+ *   writer queue is drained so the outputs are on disk, and one status line is written
+ *   back and flushed:
+ *
+ *     STATUS file=<path> result=ok|error
+ *
+ *   The loop ends when the input pipe is closed. The shared macro library and the
+ *   started threads stay warm between requests; only the per-file tables and arenas
+ *   are rebuilt, exactly as between two files of a batch run.
+ *
+ * Parameters:
+ *   keep_am_flag, cache_dir, pipeline_flag, single_pass_flag, binary_obj_flag:
+ *     The per-file options, with the meanings they have for process_file.
+ */
+
+static void server_loop(int keep_am_flag, char *cache_dir, int pipeline_flag, int single_pass_flag, int binary_obj_flag)
+{
+    char request_line[SERVER_REQUEST_LEN];
+    char *newline;
+    int status;
+
+    while (fgets(request_line, SERVER_REQUEST_LEN, stdin) != NULL)
+    {
+        newline = strchr(request_line, '\n');
+
+        if (newline != NULL)
+        {
+            *newline = '\0';
+        }
+
+        if (request_line[0] == '\0')
+        {
+            continue; /*An empty line is not a request*/
+        }
+
+        status = process_file(request_line, keep_am_flag, cache_dir, pipeline_flag, single_pass_flag, binary_obj_flag);
+
+        /*The client may read the outputs as soon as it sees the status line, so the
+          writer must have flushed them first; a failed flush means the outputs are not
+          all on disk, which the status must reflect*/
+        if (writer_thread_drain() != NO_ERRORS)
+        {
+            status = SYNTAX_OR_LOGIC_ERROR;
+        }
+
+        printf("STATUS file=%s result=%s\n", request_line, (status == NO_ERRORS) ? "ok" : "error");
+        fflush(stdout);
+    }
+}
+
+/*
+ * Function: worker_main
+ * ----------------------
+ * Description:
+ *   Entry point of a worker thread in the -j mode. Each worker repeatedly takes the index
+ *   of the next unprocessed file under the pool lock and assembles it with process_file.
+ *   Every file gets its own translation unit, macro table and AST stream (all locals of
+ *   process_file), so workers share no mutable state besides the file index.
+ *   Each diagnostic line is printed with a single stdio call, which the C library
+ *   serializes internally, so error lines from different workers are not torn.
+ *
+ * Parameters:
+ *   arg: Pointer to the shared WORKER_POOL.
+ *
+ * Returns:
+ *   NULL.
+ */
+
+static void *worker_main(void *arg)
+{
+    WORKER_POOL *pool = (WORKER_POOL *)arg;
+    int curr_arg;
+
+    while (1)
+    {
+        pthread_mutex_lock(&pool->lock);
+
+        /*Skip the command line options, they were already handled in main*/
+        while ((pool->next_arg < pool->argc) && (pool->argv[pool->next_arg][0] == '-'))
+        {
+            pool->next_arg++;
+        }
+
+        curr_arg = pool->next_arg;
+        pool->next_arg++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (curr_arg >= pool->argc)
+        {
+            return NULL;
+        }
+
+        process_file(pool->argv[curr_arg], pool->keep_am_flag, pool->cache_dir, pool->pipeline_flag, pool->single_pass_flag, pool->binary_obj_flag);
+    }
+}
+
+/*
+ * Main Function - Assembler Program
+ *
+ * Description:
+ *   The main function orchestrates the entire process of assembling assembly files.
+ *   It iterates over each file passed through the command line and assembles it with
+ *   process_file: pre-assembling, first pass, second pass, and back-end.
+ *   With the -j N option the files are distributed between N worker threads instead of
+ *   being processed sequentially, so large batches scale with the available cores.
+ *
+ * The instruction and data images grow as needed, so the program length is only limited by the
+ * 12-bit addresses that can be encoded into a memory word.
+ *
+ * Parameters:
+ *   argc: An integer representing the number of command-line arguments.
+ *   argv: An array of strings containing the command-line arguments.
+ *
+ * Return Value: 1
+ */
+
+int main(int argc, char **argv)
+{
+    int i;
+    int keep_am_flag = 0;
+    int pipeline_flag = 0;
+    int single_pass_flag = 0;
+    int server_flag = 0;
+    int binary_obj_flag = 0;
+    char *cache_dir = NULL;
+    char *macro_lib_path = NULL;
+    ARENA library_arena;
+    int jobs = 1;
+    int workers_started;
+    pthread_t workers[MAX_WORKERS];
+    WORKER_POOL pool;
+
+    /*Scanning the command line options before processing the files*/
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--keep-am") == 0)
+        {
+            keep_am_flag = 1;
+        }
+
+        else if (strcmp(argv[i], "--profile") == 0)
+        {
+            profile_enabled = 1;
+        }
+
+        else if (strcmp(argv[i], "--pipeline") == 0)
+        {
+            pipeline_flag = 1;
+        }
+
+        else if (strcmp(argv[i], "--single-pass") == 0)
+        {
+            single_pass_flag = 1;
+        }
+
+        else if (strcmp(argv[i], "--server") == 0)
+        {
+            server_flag = 1;
+        }
+
+        else if (strcmp(argv[i], "--macro-lib") == 0)
+        {
+            /*The macro library file is given as the next argument: --macro-lib <file>*/
+            if (i + 1 >= argc)
+            {
+                printf("Error: the --macro-lib option must be followed by a file\n");
+                return 1;
+            }
+
+            macro_lib_path = argv[i + 1];
+            i++; /*The next argument is the library file, not a file name to assemble*/
+            argv[i] = "-"; /*Mark it as handled so the file loops skip it*/
+        }
+
+        else if (strncmp(argv[i], "--quiet-after=", 14) == 0)
+        {
+            diag_quiet_after = atoi(argv[i] + 14);
+
+            if (diag_quiet_after < 1)
+            {
+                printf("Error: the --quiet-after option needs a positive number of errors\n");
+                return 1;
+            }
+        }
+
+        else if (strncmp(argv[i], "--obj-format=", 13) == 0)
+        {
+            if (strcmp(argv[i] + 13, "binary") == 0)
+            {
+                binary_obj_flag = 1;
+            }
+
+            else if (strcmp(argv[i] + 13, "text") != 0)
+            {
+                printf("Error: unknown object format %s , use text or binary\n", argv[i] + 13);
+                return 1;
+            }
+        }
+
+        else if (strcmp(argv[i], "--cache-dir") == 0)
+        {
+            /*The cache directory is given as the next argument: --cache-dir <dir>*/
+            if (i + 1 >= argc)
+            {
+                printf("Error: the --cache-dir option must be followed by a directory\n");
+                return 1;
+            }
+
+            cache_dir = argv[i + 1];
+            i++; /*The next argument is the cache directory, not a file name*/
+            argv[i] = "-"; /*Mark it as handled so the file loops skip it*/
+            cache_init(cache_dir);
+        }
+
+        else if (strncmp(argv[i], "-j", 2) == 0)
+        {
+            if (strcmp(argv[i], "-j") == 0)
+            {
+                /*The number of workers is given as the next argument: -j N*/
+                if (i + 1 >= argc)
+                {
+                    printf("Error: the -j option must be followed by the number of workers\n");
+                    return 1;
+                }
+
+                jobs = atoi(argv[i + 1]);
+                i++; /*The next argument is the worker count, not a file name*/
+                argv[i] = "-"; /*Mark it as handled so the file loops skip it*/
+            }
+
+            else /*The number of workers is attached to the option: -jN*/
+            {
+                jobs = atoi(argv[i] + 2);
+            }
+
+            if (jobs < 1 || jobs > MAX_WORKERS)
+            {
+                printf("Error: the number of workers must be between 1 and %d\n", MAX_WORKERS);
+                return 1;
+            }
+        }
+
+        else if (argv[i][0] == '-')
+        {
+            printf("Error: unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    /*The pipelined mode parses into an AST stream that the single-pass mode does not use*/
+    if (single_pass_flag && pipeline_flag)
+    {
+        printf("Error: the --single-pass option cannot be combined with --pipeline\n");
+        return 1;
+    }
+
+    /*The server assembles one request at a time and reads its file paths from the
+      standard input, so the batch options make no sense with it*/
+    if (server_flag)
+    {
+        if (jobs > 1)
+        {
+            printf("Error: the --server option cannot be combined with -j\n");
+            return 1;
+        }
+
+        for (i = 1; i < argc; i++)
+        {
+            if (argv[i][0] != '-')
+            {
+                printf("Error: in the server mode the file paths are read from the standard input, not the command line\n");
+                return 1;
+            }
+        }
+    }
+
+    /*The shared macro library is parsed once, before any file; its nodes live in their
+      own arena because the per-file arenas are released after every file*/
+    if (macro_lib_path != NULL)
+    {
+        arena_init(&library_arena);
+        arena_set_current(&library_arena);
+
+        if (macro_library_load(macro_lib_path) != NO_ERRORS)
+        {
+            arena_set_current(NULL);
+            arena_release(&library_arena);
+            return 1;
+        }
+
+        arena_set_current(NULL);
+    }
+
+    /*The output files of finished translation units are flushed by a background writer
+      thread while the next file is assembled; when the start fails, submitted jobs are
+      simply flushed synchronously*/
+    writer_thread_start();
+
+    if (server_flag)
+    {
+        server_loop(keep_am_flag, cache_dir, pipeline_flag, single_pass_flag, binary_obj_flag);
+    }
+
+    else if (jobs > 1)
+    {
+        pool.argv = argv;
+        pool.argc = argc;
+        pool.next_arg = 1;
+        pool.keep_am_flag = keep_am_flag;
+        pool.pipeline_flag = pipeline_flag;
+        pool.single_pass_flag = single_pass_flag;
+        pool.binary_obj_flag = binary_obj_flag;
+        pool.cache_dir = cache_dir;
+        pthread_mutex_init(&pool.lock, NULL);
+
+        for (workers_started = 0; workers_started < jobs; workers_started++)
+        {
+            if (pthread_create(&workers[workers_started], NULL, worker_main, &pool) != 0)
+            {
+                printf("Error: failed to create a worker thread\n");
+                break;
+            }
+        }
+
+        for (i = 0; i < workers_started; i++)
+        {
+            pthread_join(workers[i], NULL);
+        }
+
+        pthread_mutex_destroy(&pool.lock);
+    }
+
+    else
+    {
+        for (i = 1; i < argc; i++)
+        {
+            /*Options were already handled in the scan above*/
+            if (argv[i][0] == '-')
+            {
+                continue;
+            }
+
+            process_file(argv[i], keep_am_flag, cache_dir, pipeline_flag, single_pass_flag, binary_obj_flag);
         }
+    }
+
+    /*Every queued output must reach the disk before the process exits; the writer also
+      prints the profile lines of the handed-off files, so it stops before the report*/
+    writer_thread_finish();
 
-        free_macro_table(macro_table);
+    if (profile_enabled)
+    {
+        profile_report();
+    }
+
+    if (macro_lib_path != NULL)
+    {
+        macro_library_free();
+        arena_release(&library_arena);
     }
 
     return 1;
@@ -3,6 +3,55 @@
 #include <stdio.h>
 
 #include "include/back_end.h"
+#include "include/output_writer.h"
+
+/*
+ * Function: put_encrypted_word
+ * ----------------------------
+ * Description:
+ *   Appends the encrypted base 4 representation of one memory word to the output buffer.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - word: The memory word to encode.
+ * Algorithm:
+ *   - Extract the seven 2-bit fields of the word from the most significant to the least
+ *     significant and append the encryption character of each field.
+ */
+
+static void put_encrypted_word(OUTPUT_WRITER *writer, int word)
+{
+    char Encrypted_base_four[] = {'*', '#', '%', '!'};
+    int shift;
+
+    for (shift = 12; shift >= 0; shift -= 2)
+    {
+        output_writer_put_char(writer, Encrypted_base_four[(word >> shift) & 3]);
+    }
+}
+
+/*
+ * Function: memory_word_at
+ * ------------------------
+ * Description:
+ *   Reads one word of the unified memory view of a translation unit: the addresses
+ *   below ic belong to the instruction image and the rest to the data image, so the
+ *   emitters sweep the whole image with one linear loop.
+ * Parameters:
+ *   - curr_program: The translation unit holding the two packed images.
+ *   - index: The zero-based address of the word, below ic + dc.
+ * Returns:
+ *   - The 14-bit word at that address.
+ */
+
+static int memory_word_at(TRANSLATION_UNIT *curr_program, int index)
+{
+    if (index < curr_program->ic)
+    {
+        return memory_image_get(&curr_program->instruction_image, index);
+    }
+
+    return memory_image_get(&curr_program->data_image, index - curr_program->ic);
+}
 
 /*
  * Function: create_object_file
@@ -21,20 +70,15 @@
  *
  * Algorithm:
  *   1. Concatenate ".ob" extension to the provided file_name to get the output file name.
- *   2. Open the output file for writing.
- *   3. Write the header containing the instruction counter (ic) and the data counter (dc) to the file.
- *   4. Iterate through the instruction array and data array, encoding the content in encrypted base 4 and writing the address and content to the file.
- *   5. Close the output file and free the dynamically allocated memory.
+ *   2. Encode the header containing the instruction counter (ic) and the data counter (dc) into the output buffer.
+ *   3. Iterate through the instruction array and data array, encoding the address and the content in encrypted base 4 into the output buffer.
+ *   4. Flush the whole buffer to the object file with a single write.
  */
 int create_object_file(TRANSLATION_UNIT *curr_program, char *file_name)
 {
-
-    char Encrypted_base_four[] = {'*', '#', '%', '!'};
+    OUTPUT_WRITER writer;
     char *ob_file_name;
-    FILE *ob_file;
     int i;
-    int address;
-    short bits_0_1, bits_2_3, bits_4_5, bits_6_7, bits_8_9, bits_10_11, bits_12_13;
 
     ob_file_name = dynamic_strcat(file_name, ".ob");
     if (ob_file_name == NULL)
@@ -43,52 +87,164 @@ int create_object_file(TRANSLATION_UNIT *curr_program, char *file_name)
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    ob_file = fopen(ob_file_name, "w");
-
-    if (ob_file == NULL)
+    if (output_writer_init(&writer) == MEMORY_ALLOCATION_ERROR)
     {
-        printf("Error the file : %s , cannot be opened\n", ob_file_name);
-        free(ob_file_name);
+        printf("Error the file : %s , memory allocation failed \n", ob_file_name);
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    fprintf(ob_file, "  %d %d\n", curr_program->ic, curr_program->dc);
+    output_writer_put_string(&writer, "  ");
+    output_writer_put_number(&writer, curr_program->ic);
+    output_writer_put_char(&writer, ' ');
+    output_writer_put_number(&writer, curr_program->dc);
+    output_writer_put_char(&writer, '\n');
 
-    for (i = 0; i < curr_program->ic; i++)
+    /*One linear sweep over the unified view: instructions first, data right after, all
+      loaded from address 100 on*/
+    for (i = 0; i < curr_program->ic + curr_program->dc; i++)
     {
-        address = i + 100;
-        bits_0_1 = curr_program->instruction_array[i] & 3;
-        bits_2_3 = (curr_program->instruction_array[i] >> 2) & 3;
-        bits_4_5 = (curr_program->instruction_array[i] >> 4) & 3;
-        bits_6_7 = (curr_program->instruction_array[i] >> 6) & 3;
-        bits_8_9 = (curr_program->instruction_array[i] >> 8) & 3;
-        bits_10_11 = (curr_program->instruction_array[i] >> 10) & 3;
-        bits_12_13 = (curr_program->instruction_array[i] >> 12) & 3;
-
-        fprintf(ob_file, "0%d %c%c%c%c%c%c%c\n", address, Encrypted_base_four[bits_12_13], Encrypted_base_four[bits_10_11], Encrypted_base_four[bits_8_9],
-                Encrypted_base_four[bits_6_7], Encrypted_base_four[bits_4_5], Encrypted_base_four[bits_2_3], Encrypted_base_four[bits_0_1]);
+        output_writer_put_char(&writer, '0');
+        output_writer_put_number(&writer, i + 100);
+        output_writer_put_char(&writer, ' ');
+        put_encrypted_word(&writer, memory_word_at(curr_program, i));
+        output_writer_put_char(&writer, '\n');
     }
 
     curr_program->ic += 100;
 
-    for (i = 0; i < curr_program->dc; i++)
+    return output_writer_flush(&writer, ob_file_name);
+}
+
+/*
+ * Function: put_u16_le
+ * --------------------
+ * Description:
+ *   Appends a 16-bit value to the output buffer in little-endian byte order.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - value: The value to append.
+ */
+
+static void put_u16_le(OUTPUT_WRITER *writer, unsigned int value)
+{
+    output_writer_put_char(writer, (char)(value & 0xFF));
+    output_writer_put_char(writer, (char)((value >> 8) & 0xFF));
+}
+
+/*
+ * Function: put_u32_le
+ * --------------------
+ * Description:
+ *   Appends a 32-bit value to the output buffer in little-endian byte order.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - value: The value to append.
+ */
+
+static void put_u32_le(OUTPUT_WRITER *writer, unsigned long value)
+{
+    output_writer_put_char(writer, (char)(value & 0xFF));
+    output_writer_put_char(writer, (char)((value >> 8) & 0xFF));
+    output_writer_put_char(writer, (char)((value >> 16) & 0xFF));
+    output_writer_put_char(writer, (char)((value >> 24) & 0xFF));
+}
+
+/*
+ * Function: put_name_record
+ * -------------------------
+ * Description:
+ *   Appends one table record of the binary object format: a 32-bit address followed by
+ *   the length-prefixed symbol name (one length byte, then the name without a null).
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - address: The address of the record.
+ *   - name: The symbol name, at most MAX_LABEL_LEN - 1 characters.
+ */
+
+static void put_name_record(OUTPUT_WRITER *writer, int address, char *name)
+{
+    int name_length = strlen(name);
+    int i;
+
+    put_u32_le(writer, (unsigned long)address);
+    output_writer_put_char(writer, (char)name_length);
+
+    for (i = 0; i < name_length; i++)
     {
-        address = i + curr_program->ic;
-        bits_0_1 = curr_program->data_array[i] & 3;
-        bits_2_3 = (curr_program->data_array[i] >> 2) & 3;
-        bits_4_5 = (curr_program->data_array[i] >> 4) & 3;
-        bits_6_7 = (curr_program->data_array[i] >> 6) & 3;
-        bits_8_9 = (curr_program->data_array[i] >> 8) & 3;
-        bits_10_11 = (curr_program->data_array[i] >> 10) & 3;
-        bits_12_13 = (curr_program->data_array[i] >> 12) & 3;
+        output_writer_put_char(writer, name[i]);
+    }
+}
+
+/*
+ * Function: create_binary_object_file
+ * -----------------------------------
+ * Description:
+ *   Creates the object file in the binary format selected with --obj-format=binary.
+ *   The whole image is one little-endian blob built in memory and flushed with a single
+ *   write, so the loader reads it back without parsing any text. The layout is:
+ *     - 4 magic bytes "ASOB", a 16-bit format version (currently 1) and a 16-bit
+ *       reserved field.
+ *     - The instruction count and the data count as 32-bit values. The image is loaded
+ *       at address 100, like the text format.
+ *     - One 16-bit word per instruction word, then one per data word, in address order.
+ *     - The entries table: a 32-bit record count, then one record per entry symbol.
+ *     - The externals table: a 32-bit record count, then one record per external
+ *       reference, in the same order as the .ext file.
+ *   Each table record is a 32-bit address followed by the length-prefixed symbol name.
+ *
+ * Parameters:
+ *   - curr_program: Pointer to the central processing unit that contains all the relevant information about the current program.
+ *   - file_name: The file name without the .ob extension.
+ *
+ * Returns:
+ *   - MEMORY_ALLOCATION_ERROR if memory allocation or file opening failed, otherwise returns NO_ERRORS.
+ */
 
-        fprintf(ob_file, "0%d %c%c%c%c%c%c%c\n", address, Encrypted_base_four[bits_12_13], Encrypted_base_four[bits_10_11], Encrypted_base_four[bits_8_9],
-                Encrypted_base_four[bits_6_7], Encrypted_base_four[bits_4_5], Encrypted_base_four[bits_2_3], Encrypted_base_four[bits_0_1]);
+int create_binary_object_file(TRANSLATION_UNIT *curr_program, char *file_name)
+{
+    OUTPUT_WRITER writer;
+    char *ob_file_name;
+    int i;
+
+    ob_file_name = dynamic_strcat(file_name, ".ob");
+    if (ob_file_name == NULL)
+    {
+        printf("Error the file : %s , memory allocation failed \n", file_name);
+        return MEMORY_ALLOCATION_ERROR;
     }
 
-    fclose(ob_file);
-    free(ob_file_name);
-    return NO_ERRORS;
+    if (output_writer_init(&writer) == MEMORY_ALLOCATION_ERROR)
+    {
+        printf("Error the file : %s , memory allocation failed \n", ob_file_name);
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    output_writer_put_string(&writer, "ASOB");
+    put_u16_le(&writer, 1); /*Format version*/
+    put_u16_le(&writer, 0); /*Reserved*/
+    put_u32_le(&writer, (unsigned long)curr_program->ic);
+    put_u32_le(&writer, (unsigned long)curr_program->dc);
+
+    for (i = 0; i < curr_program->ic + curr_program->dc; i++)
+    {
+        put_u16_le(&writer, (unsigned int)memory_word_at(curr_program, i));
+    }
+
+    put_u32_le(&writer, (unsigned long)curr_program->entries_counter);
+
+    for (i = 0; i < curr_program->entries_counter; i++)
+    {
+        put_name_record(&writer, curr_program->entries[i]->address, curr_program->entries[i]->name);
+    }
+
+    put_u32_le(&writer, (unsigned long)curr_program->external_counter);
+
+    for (i = 0; i < curr_program->external_counter; i++)
+    {
+        put_name_record(&writer, curr_program->ext_refs[i].address + 100, curr_program->ext_refs[i].ext_name);
+    }
+
+    return output_writer_flush(&writer, ob_file_name);
 }
 
 /*
@@ -106,16 +262,15 @@ int create_object_file(TRANSLATION_UNIT *curr_program, char *file_name)
  *
  * Algorithm:
  *   1. Concatenate ".ent" extension to the provided file_name to get the output file name.
- *   2. Open the output file for writing.
- *   3. Iterate through the entries list, writing each symbol name and its corresponding address to the file.
- *   4. Close the output file and free the dynamically allocated memory.
+ *   2. Iterate through the entries list, encoding each symbol name and its corresponding address into the output buffer.
+ *   3. Flush the whole buffer to the entries file with a single write.
  */
 
 int create_entries_file(TRANSLATION_UNIT *curr_program, char *file_name)
 {
+    OUTPUT_WRITER writer;
     char *ent_file_name;
-    FILE *ent_file;
-    ENTRY_NODE *entry_ptr = curr_program->entries_list;
+    int i;
 
     ent_file_name = dynamic_strcat(file_name, ".ent");
 
@@ -125,24 +280,24 @@ int create_entries_file(TRANSLATION_UNIT *curr_program, char *file_name)
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    ent_file = fopen(ent_file_name, "w");
-
-    if (ent_file == NULL)
+    if (output_writer_init(&writer) == MEMORY_ALLOCATION_ERROR)
     {
-        printf("Error the file : %s , cannot be opened\n", ent_file_name);
-        free(ent_file_name);
+        printf("Error the file : %s , memory allocation failed\n", ent_file_name);
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    while (entry_ptr != NULL)
+    /*The vector was sorted by address when the symbols were finalized, so the sweep
+      emits the file in address order with no pointer chasing*/
+    for (i = 0; i < curr_program->entries_counter; i++)
     {
-        fprintf(ent_file, "%s\t0%d\n", entry_ptr->symbol->name, entry_ptr->symbol->address);
-        entry_ptr = entry_ptr->next;
+        output_writer_put_string(&writer, curr_program->entries[i]->name);
+        output_writer_put_char(&writer, '\t');
+        output_writer_put_char(&writer, '0');
+        output_writer_put_number(&writer, curr_program->entries[i]->address);
+        output_writer_put_char(&writer, '\n');
     }
 
-    fclose(ent_file);
-    free(ent_file_name);
-    return NO_ERRORS;
+    return output_writer_flush(&writer, ent_file_name);
 }
 
 /*
@@ -163,20 +318,17 @@ int create_entries_file(TRANSLATION_UNIT *curr_program, char *file_name)
  *
  * Algorithm:
  *   1. Concatenate ".ext" extension to the provided file name to obtain the output file name.
- *   2. Open the output file for writing.
- *   3. Iterate through the list of external symbols, and for each symbol:
+ *   2. Iterate through the list of external symbols, and for each symbol:
  *      a. Iterate through its associated addresses in the machine code.
- *      b. Write each address-symbol pair to the file.
- *   4. Close the output file and free the dynamically allocated memory.
+ *      b. Encode each address-symbol pair into the output buffer.
+ *   3. Flush the whole buffer to the externals file with a single write.
  */
 
 int create_external_file(TRANSLATION_UNIT *curr_program, char *file_name)
 {
+    OUTPUT_WRITER writer;
     char *ext_file_name;
-    FILE *ext_file;
-    EXT_SYMBOL *ext_ptr = curr_program->ext_list;
-    EXT_ADDRESS *address_ptr;
-    int address;
+    int i;
 
     ext_file_name = dynamic_strcat(file_name, ".ext");
     if (ext_file_name == NULL)
@@ -186,31 +338,22 @@ int create_external_file(TRANSLATION_UNIT *curr_program, char *file_name)
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    ext_file = fopen(ext_file_name, "w");
-
-    if (ext_file == NULL)
+    if (output_writer_init(&writer) == MEMORY_ALLOCATION_ERROR)
     {
-
-        printf("Error the file : %s , cannot be opened\n", ext_file_name);
-        free(ext_file_name);
+        printf("Error the file : %s , memory allocation failed \n", ext_file_name);
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    while (ext_ptr != NULL)
+    /*The references were appended in encoding order, so the vector is already sorted
+      by address and the sweep emits the file in that order*/
+    for (i = 0; i < curr_program->external_counter; i++)
     {
-        address_ptr = ext_ptr->address;
-
-        while (address_ptr != NULL)
-        {
-            address = address_ptr->num + 100;
-            fprintf(ext_file, "%s\t0%d\n", ext_ptr->ext_name, address);
-            address_ptr = address_ptr->next_address;
-        }
-        ext_ptr = ext_ptr->next_ext;
+        output_writer_put_string(&writer, curr_program->ext_refs[i].ext_name);
+        output_writer_put_char(&writer, '\t');
+        output_writer_put_char(&writer, '0');
+        output_writer_put_number(&writer, curr_program->ext_refs[i].address + 100);
+        output_writer_put_char(&writer, '\n');
     }
 
-    fclose(ext_file);
-    free(ext_file_name);
-    return NO_ERRORS;
+    return output_writer_flush(&writer, ext_file_name);
 }
-
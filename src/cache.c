@@ -0,0 +1,252 @@
+/*
+ * File: cache.c
+ * -------------
+ * Description:
+ *   This file implements the incremental assembly cache behind the --cache-dir option.
+ *   The key of a file is a hash of its macro-expanded source, so it covers the content
+ *   of the .as file and of every macro it pulls in. When the key of a file matches an
+ *   entry in the cache directory, the passes are skipped entirely and the previously
+ *   emitted .ob/.ent/.ext outputs are copied back; when it does not, the file is
+ *   assembled normally and its outputs are stored under the key for the next run.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "include/general.h"
+#include "include/cache.h"
+
+/*
+ * Function: cache_init
+ * ---------------------
+ * Description:
+ *   Creates the cache directory if it does not exist yet. A failure is ignored here:
+ *   when the directory is unusable, every lookup simply misses and every store fails
+ *   silently, so the batch still assembles correctly without the cache.
+ *
+ * Parameters:
+ *   cache_dir: Path of the cache directory given with --cache-dir.
+ */
+
+void cache_init(char *cache_dir)
+{
+    mkdir(cache_dir, 0755);
+}
+
+/*
+ * Function: cache_key
+ * --------------------
+ * Description:
+ *   Computes the content key of an expanded source buffer. Two independent 32-bit
+ *   hashes (djb2 and sdbm) are written as 16 hex characters, so unrelated contents
+ *   colliding on the same key is not a practical concern for a CI batch.
+ *
+ * Parameters:
+ *   am_buffer: The macro-expanded source of the file.
+ *   key_out: Output buffer of at least CACHE_KEY_LEN characters.
+ */
+
+void cache_key(char *am_buffer, char *key_out)
+{
+    unsigned int hash_a = 5381;
+    unsigned int hash_b = 0;
+    int i;
+
+    for (i = 0; am_buffer[i] != '\0'; i++)
+    {
+        hash_a = ((hash_a << 5) + hash_a) + (unsigned char)am_buffer[i];
+        hash_b = (unsigned char)am_buffer[i] + (hash_b << 6) + (hash_b << 16) - hash_b;
+    }
+
+    sprintf(key_out, "%08x%08x", hash_a, hash_b);
+}
+
+/*
+ * Function: cache_path
+ * ---------------------
+ * Description:
+ *   Builds the path of one cached output: <cache_dir>/<key><extension>. The path is
+ *   drawn from the per-file arena, so it is released with the rest of the file.
+ *
+ * Parameters:
+ *   cache_dir: Path of the cache directory.
+ *   key: The content key of the expanded source.
+ *   extension: The extension of the output, including the dot.
+ *
+ * Returns:
+ *   The path, or NULL if memory allocation fails.
+ */
+
+static char *cache_path(char *cache_dir, char *key, char *extension)
+{
+    char *dir_part;
+    char *key_part;
+
+    dir_part = dynamic_strcat(cache_dir, "/");
+
+    if (dir_part == NULL)
+    {
+        return NULL;
+    }
+
+    key_part = dynamic_strcat(dir_part, key);
+
+    if (key_part == NULL)
+    {
+        return NULL;
+    }
+
+    return dynamic_strcat(key_part, extension);
+}
+
+/*
+ * Function: copy_file
+ * --------------------
+ * Description:
+ *   Copies one file in blocks of CACHE_COPY_BUFFER bytes.
+ *
+ * Parameters:
+ *   src_path: Path of the file to copy.
+ *   dst_path: Path of the copy to create.
+ *
+ * Returns:
+ *   1 when the copy succeeded, 0 when the source does not exist or a file cannot be
+ *   opened or written.
+ */
+
+static int copy_file(char *src_path, char *dst_path)
+{
+    FILE *src;
+    FILE *dst;
+    char buffer[CACHE_COPY_BUFFER];
+    size_t read_count;
+    int success = 1;
+
+    src = fopen(src_path, "rb");
+
+    if (src == NULL)
+    {
+        return 0;
+    }
+
+    dst = fopen(dst_path, "wb");
+
+    if (dst == NULL)
+    {
+        fclose(src);
+        return 0;
+    }
+
+    while ((read_count = fread(buffer, 1, CACHE_COPY_BUFFER, src)) > 0)
+    {
+        if (fwrite(buffer, 1, read_count, dst) != read_count)
+        {
+            success = 0;
+            break;
+        }
+    }
+
+    fclose(src);
+    fclose(dst);
+    return success;
+}
+
+/*
+ * Function: cache_restore
+ * ------------------------
+ * Description:
+ *   Restores the outputs of a file from the cache. The .ob entry decides whether the
+ *   key is cached at all; the .ent and .ext entries are optional because a file only
+ *   emits them when it has entry or external symbols.
+ *
+ * Parameters:
+ *   cache_dir: Path of the cache directory.
+ *   key: The content key of the expanded source.
+ *   file_name: The name of the input file, without the .as extension.
+ *
+ * Returns:
+ *   1 when the outputs were restored from the cache, 0 when there is no usable entry.
+ */
+
+int cache_restore(char *cache_dir, char *key, char *file_name)
+{
+    char *cached_path;
+    char *output_path;
+
+    cached_path = cache_path(cache_dir, key, ".ob");
+    output_path = dynamic_strcat(file_name, ".ob");
+
+    if (cached_path == NULL || output_path == NULL)
+    {
+        return 0;
+    }
+
+    /*A missing .ob entry means the key was never stored, so the file is assembled normally*/
+    if (copy_file(cached_path, output_path) == 0)
+    {
+        return 0;
+    }
+
+    cached_path = cache_path(cache_dir, key, ".ent");
+    output_path = dynamic_strcat(file_name, ".ent");
+
+    if (cached_path != NULL && output_path != NULL)
+    {
+        copy_file(cached_path, output_path);
+    }
+
+    cached_path = cache_path(cache_dir, key, ".ext");
+    output_path = dynamic_strcat(file_name, ".ext");
+
+    if (cached_path != NULL && output_path != NULL)
+    {
+        copy_file(cached_path, output_path);
+    }
+
+    return 1;
+}
+
+/*
+ * Function: cache_store
+ * ----------------------
+ * Description:
+ *   Stores the outputs that were just emitted for a file in the cache. The optional
+ *   .ent and .ext outputs are stored first so that once the .ob entry appears, the
+ *   whole entry is usable by cache_restore.
+ *
+ * Parameters:
+ *   cache_dir: Path of the cache directory.
+ *   key: The content key of the expanded source.
+ *   file_name: The name of the input file, without the .as extension.
+ */
+
+void cache_store(char *cache_dir, char *key, char *file_name)
+{
+    char *cached_path;
+    char *output_path;
+
+    cached_path = cache_path(cache_dir, key, ".ent");
+    output_path = dynamic_strcat(file_name, ".ent");
+
+    if (cached_path != NULL && output_path != NULL)
+    {
+        copy_file(output_path, cached_path);
+    }
+
+    cached_path = cache_path(cache_dir, key, ".ext");
+    output_path = dynamic_strcat(file_name, ".ext");
+
+    if (cached_path != NULL && output_path != NULL)
+    {
+        copy_file(output_path, cached_path);
+    }
+
+    cached_path = cache_path(cache_dir, key, ".ob");
+    output_path = dynamic_strcat(file_name, ".ob");
+
+    if (cached_path != NULL && output_path != NULL)
+    {
+        copy_file(output_path, cached_path);
+    }
+}
@@ -0,0 +1,206 @@
+/*
+ * File: diag.c
+ * ------------
+ * Description:
+ *   This file implements the buffered diagnostics sink. The error sites of the
+ *   pre-assembler and the passes used to print straight to the console, one unbuffered
+ *   write per error with no cap, so a badly broken generated file could emit hundreds
+ *   of thousands of lines and become I/O bound on the terminal. Each file now opens a
+ *   sink that accumulates its error lines in memory and flushes them with one write at
+ *   the end of the file; with --quiet-after=N the sink stops keeping lines after N
+ *   errors and diag_limit_reached lets the per-line loops of the passes stop parsing,
+ *   so the failure path is as fast as the success path. The sink of the running thread
+ *   is installed with a thread key like the arena, so the error sites need no extra
+ *   parameter; a thread without a sink (the pipeline producer, the writer thread, the
+ *   benchmarks) prints directly, exactly as before.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "include/diag.h"
+
+int diag_quiet_after = 0;
+
+static pthread_key_t current_diag_key;
+static pthread_once_t current_diag_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Function: create_current_diag_key
+ * ----------------------------------
+ * Description:
+ *   Creates the thread key holding the sink of each thread.
+ *   Executed exactly once through pthread_once.
+ */
+
+static void create_current_diag_key(void)
+{
+    pthread_key_create(&current_diag_key, NULL);
+}
+
+/*
+ * Function: diag_open
+ * --------------------
+ * Description:
+ *   Initializes the sink with the configured limit and installs it as the sink of the
+ *   calling thread. The buffer is allocated lazily by the first error, so clean files
+ *   pay nothing.
+ *
+ * Parameters:
+ *   - diag: The sink to open.
+ */
+
+void diag_open(DIAG *diag)
+{
+    diag->buffer = NULL;
+    diag->length = 0;
+    diag->capacity = 0;
+    diag->reported = 0;
+    diag->suppressed = 0;
+    diag->limit = diag_quiet_after;
+
+    pthread_once(&current_diag_once, create_current_diag_key);
+    pthread_setspecific(current_diag_key, diag);
+}
+
+/*
+ * Function: diag_error
+ * ---------------------
+ * Description:
+ *   Formats one diagnostic line into the sink of the calling thread. The line embeds
+ *   the caller-supplied file path, which can approach PATH_MAX, so no fixed headroom
+ *   is safe: the line is measured with vsnprintf first and the buffer is grown to fit
+ *   it exactly before it is formatted in. Without a sink, or when the buffer cannot
+ *   grow, the line is printed directly instead of being lost.
+ *
+ * Parameters:
+ *   - format: The printf format of the line, followed by its arguments.
+ */
+
+void diag_error(char *format, ...)
+{
+    DIAG *diag;
+    char *grown;
+    int new_capacity;
+    int needed;
+    va_list args;
+
+    pthread_once(&current_diag_once, create_current_diag_key);
+    diag = (DIAG *)pthread_getspecific(current_diag_key);
+
+    if (diag == NULL)
+    {
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+
+    if (diag->limit > 0 && diag->reported >= diag->limit)
+    {
+        diag->suppressed++;
+        return;
+    }
+
+    /*Measure the line; vsnprintf returns the length it needs regardless of the size
+      passed, so the buffer can be grown to fit before formatting for real*/
+    va_start(args, format);
+    needed = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    if (needed < 0)
+    {
+        return;
+    }
+
+    if (diag->length + needed + 1 > diag->capacity)
+    {
+        new_capacity = (diag->capacity == 0) ? DIAG_INITIAL_CAPACITY : diag->capacity * 2;
+
+        while (diag->length + needed + 1 > new_capacity)
+        {
+            new_capacity *= 2;
+        }
+
+        grown = (char *)realloc(diag->buffer, new_capacity * sizeof(char));
+
+        if (grown == NULL)
+        {
+            va_start(args, format);
+            vprintf(format, args);
+            va_end(args);
+            return;
+        }
+
+        diag->buffer = grown;
+        diag->capacity = new_capacity;
+    }
+
+    va_start(args, format);
+    vsnprintf(diag->buffer + diag->length, diag->capacity - diag->length, format, args);
+    va_end(args);
+
+    diag->length += needed;
+    diag->reported++;
+}
+
+/*
+ * Function: diag_limit_reached
+ * -----------------------------
+ * Description:
+ *   Tells whether the sink of the calling thread has reached its error limit.
+ *
+ * Returns:
+ *   - 1 when the limit was reached, 0 otherwise (including when there is no sink or limit).
+ */
+
+int diag_limit_reached(void)
+{
+    DIAG *diag;
+
+    pthread_once(&current_diag_once, create_current_diag_key);
+    diag = (DIAG *)pthread_getspecific(current_diag_key);
+
+    return (diag != NULL && diag->limit > 0 && diag->reported >= diag->limit);
+}
+
+/*
+ * Function: diag_flush
+ * ---------------------
+ * Description:
+ *   Prints the accumulated diagnostics with a single stdio call, so the lines of a
+ *   file are not torn by other threads, notes how many further errors were dropped
+ *   when the limit was reached, releases the buffer and uninstalls the sink.
+ *
+ * Parameters:
+ *   - diag: The sink to flush.
+ */
+
+void diag_flush(DIAG *diag)
+{
+    if (diag->length > 0)
+    {
+        printf("%s", diag->buffer);
+    }
+
+    if (diag->suppressed > 0)
+    {
+        printf("Error reporting stopped after %d errors , %d further errors were not shown (--quiet-after)\n",
+               diag->limit, diag->suppressed);
+    }
+
+    else if (diag->limit > 0 && diag->reported >= diag->limit)
+    {
+        printf("Error reporting stopped after %d errors (--quiet-after)\n", diag->limit);
+    }
+
+    free(diag->buffer);
+    diag->buffer = NULL;
+    diag->length = 0;
+    diag->capacity = 0;
+
+    pthread_setspecific(current_diag_key, NULL);
+}
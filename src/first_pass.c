@@ -6,6 +6,10 @@
 #include "include/front_end.h"
 #include "include/general.h"
 #include "include/pre_assembler.h"
+#include "include/arena.h"
+#include "include/profile.h"
+#include "include/second_pass.h"
+#include "include/diag.h"
 
 /* 
  * Function: insert_symbol
@@ -25,42 +29,93 @@
  *   Returns NO_ERRORS (0) if the operation is successful. Returns MEMORY_ALLOCATION_ERROR (-2) if memory allocation fails.
  *
  * Algorithm:
- *   1. Calculate the hash index for the symbol name.
- *   2. Allocate memory for a new symbol structure.
- *   3. Copy the symbol name and other details into the new symbol structure.
- *   4. Insert the symbol into the symbol table at the calculated index.
+ *   1. Allocate memory for a new symbol structure from the per-file arena.
+ *   2. Copy the symbol name and other details into the new symbol structure.
+ *   3. Insert the symbol into the open-addressing symbol table.
  */
 
-int insert_symbol(SYMBOL *symbol_table[HASH_TABLE_SIZE], char *symbol_name, int symbol_type, int address, int value)
+int insert_symbol(HASH_TABLE *symbol_table, char *symbol_name, int symbol_type, int address, int value)
 {
-    unsigned int index = hash(symbol_name);
-    SYMBOL *new_symbol = (SYMBOL *)malloc(sizeof(SYMBOL));
+    SYMBOL *new_symbol;
+
+    profile_count_alloc(profile_alloc_insert_symbol);
+    new_symbol = (SYMBOL *)arena_alloc_current(sizeof(SYMBOL));
 
     if (new_symbol == NULL)
     {
         return MEMORY_ALLOCATION_ERROR;
     }
 
-    strcpy(new_symbol->name, symbol_name);
+    new_symbol->name = symbol_name; /*Interned by the front end, stored once per file*/
     new_symbol->type = symbol_type;
     new_symbol->address = address;
     new_symbol->value = value;
-    new_symbol->next = NULL;
 
-    if (symbol_table[index] == NULL)
-    {
-        symbol_table[index] = new_symbol;
-        return NO_ERRORS;
-    }
+    return hash_table_insert(symbol_table, new_symbol->name, new_symbol);
+}
 
-    else
+
+/*
+ * Function: ast_stream_append
+ * ----------------------------
+ * Description:
+ *   Appends a parsed line to the AST stream, growing the stream if needed.
+ *
+ * Parameters:
+ *   ast_stream: The stream to append to.
+ *   ast: The parsed line to store.
+ *   line_num: The number of the line in the am source.
+ *   cells: The number of memory cells the line occupies, or -1 when not computed yet.
+ *
+ * Returns:
+ *   NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ *
+ * Algorithm:
+ *   1. If the stream is full, double its capacity with realloc.
+ *   2. Copy the AST, the line number and the cell count into the next free node.
+ */
+
+int ast_stream_append(AST_STREAM *ast_stream, LINE_AST *ast, int line_num, int cells)
+{
+    AST_NODE *temp;
+
+    if (ast_stream->count == ast_stream->capacity)
     {
-        new_symbol->next = symbol_table[index];
-        symbol_table[index] = new_symbol;
-        return NO_ERRORS;
+        ast_stream->capacity = (ast_stream->capacity == 0) ? AST_STREAM_INITIAL_CAPACITY : ast_stream->capacity * 2;
+        temp = (AST_NODE *)realloc(ast_stream->nodes, ast_stream->capacity * sizeof(AST_NODE));
+
+        if (temp == NULL)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        ast_stream->nodes = temp;
     }
+
+    ast_stream->nodes[ast_stream->count].ast = *ast;
+    ast_stream->nodes[ast_stream->count].line_num = line_num;
+    ast_stream->nodes[ast_stream->count].cells = cells;
+    ast_stream->count++;
+    return NO_ERRORS;
 }
 
+/*
+ * Function: free_ast_stream
+ * --------------------------
+ * Description:
+ *   Frees the memory allocated for the nodes of an AST stream.
+ *
+ * Parameters:
+ *   ast_stream: The stream whose nodes should be freed.
+ */
+
+void free_ast_stream(AST_STREAM *ast_stream)
+{
+    free(ast_stream->nodes);
+    ast_stream->nodes = NULL;
+    ast_stream->count = 0;
+    ast_stream->capacity = 0;
+}
 
 /* 
  * Function: memory_cell_calculator
@@ -149,306 +204,580 @@ int memory_cell_calculator(LINE_AST line)
 }
 
 
-/* 
- * Function: first_pass
- * ---------------------
+/*
+ * Function: process_parsed_line
+ * ------------------------------
  * Description:
- *   Performs the first pass of the assembly process. It reads each line from the assembly file,
- *   parses it into an abstract syntax tree (AST), processes the AST to update memory counters,
- *   and builds the symbol table. If a syntax error is encountered during processing, it prints
- *   an error message and handles it appropriately.
+ *   Processes one parsed line of the first pass: reports syntax errors, builds the
+ *   symbol table and advances the memory counters. Shared by first_pass, which parses
+ *   the expanded source itself, and first_pass_from_stream, which walks lines that were
+ *   already parsed by the pipelined consumer.
  *
  * Parameters:
  *   curr_program: Pointer to the current translation unit being processed.
- *   am_file: Pointer to the assembly file.
- *   am_file_name: Name of the assembly file.
- *   macro_table: An array of pointers to MACRO structures representing macro definitions.
+ *   line_ast: The parsed line.
+ *   line_num: The number of the line in the am source (used in error messages).
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   ic: Pointer to the instruction counter, advanced by instruction lines.
+ *   dc: Pointer to the data counter, advanced by data and string lines.
+ *   cells_hint: The memory cells of the line when they were computed in advance, or -1
+ *               to compute them here with memory_cell_calculator.
  *
  * Returns:
- *   An integer representing the success or failure of the operation.
- *   Returns NO_ERRORS  if the operation is successful. Returns SYNTAX_OR_LOGIC_ERROR 
- *   if a syntax or logic error is encountered during processing and MEMORY_ALLOCATION_ERROR  If memory allocation fails.
- *
- * Algorithm:
- *   1. Read each line from the assembly file.
- *   2. Parse the line into an abstract syntax tree (AST).
- *   3. Process the AST to update memory counters and build the symbol table.
- *   4. Handle syntax errors:
- *      - Print an error message with file name and line number.
- *      - If memory allocation fails, return MEMORY_ALLOCATION_ERROR (-1).
- *   5. Return appropriate status codes based on success or failure.
+ *   NO_ERRORS if the line was processed successfully, SYNTAX_OR_LOGIC_ERROR if the line
+ *   contains a syntax or logic error (already reported) and MEMORY_ALLOCATION_ERROR if
+ *   memory allocation fails.
  */
 
-int first_pass(TRANSLATION_UNIT *curr_program, FILE *am_file, char *am_file_name, MACRO *macro_table[HASH_TABLE_SIZE])
+static int process_parsed_line(TRANSLATION_UNIT *curr_program, LINE_AST *line_ast, int line_num, char *am_file_name, HASH_TABLE *macro_table, int *ic, int *dc, int cells_hint)
 {
-
-    char line[MAX_LINE_LEN];
-    int ic = 100;
-    int dc = 0;
-    int err_flag = NO_ERRORS;
-    int line_num = 1;
-    int i;
-    int added_memory;
-    LINE_AST line_ast = {0};
     SYMBOL *sym_find;
-    SYMBOL *sym_ptr;
+    int added_memory;
 
-    while (fgets(line, MAX_LINE_LEN, am_file))
+    /*Chceck if there is syntax error*/
+    if (line_ast->type == error)
     {
-        added_memory = 0;
-        line_ast = create_ast_from_text(line);
 
-        /*Chceck if there is syntax error*/
-        if (line_ast.type == error)
+        diag_error("Error in: %s , in line number: %d , %s\n", am_file_name, line_num, line_ast->error_detail);
+
+        /*If memory allocation failed, the program must be stopped for the current file*/
+        if (strcmp(line_ast->error_detail, "memory allocation failed") == 0)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        return SYNTAX_OR_LOGIC_ERROR;
+    }
+
+    if (line_ast->type == dir || line_ast->type == inst)
+    {
+        /*Checking a scenario in which a label is defined (for a directive or an instruction)*/
+        if (line_ast->label != NULL)
         {
 
-            printf("Error in: %s , in line number: %d , %s\n", am_file_name, line_num, line_ast.error_detail);
-            
-            /*If memory allocation failed, the program must be stopped for the current file*/
-            if (strcmp(line_ast.error_detail, "memory allocation failed") == 0)
+            if (macro_lookup(line_ast->label, macro_table) != NULL)
             {
-                return MEMORY_ALLOCATION_ERROR;
+                diag_error("Error in: %s, in line number: %d , redefining a name for a macro and symbol\n", am_file_name, line_num);
+                return SYNTAX_OR_LOGIC_ERROR;
             }
 
-            line_num++;
-            err_flag = SYNTAX_OR_LOGIC_ERROR;
-            continue;
+            else
+            {
+
+                sym_find = symbol_lookup(line_ast->label, &curr_program->symbol_table);
+
+                if (sym_find)
+                {
+                    /*if the label was previously defined as an entry, we will associate the current address with it*/
+                    if (sym_find->type == entry_sym_without_definition)
+                    {
+                        if (line_ast->type == dir)
+                        {
+                            sym_find->type = data_entry_sym;
+                            sym_find->address = *dc;
+                        }
+
+                        else
+                        {
+                            sym_find->type = inst_entry_sym;
+                            sym_find->address = *ic;
+                        }
+                    }
+
+                    /*It was previously defined without an entry, this is a repeated definition and therefore an error */
+                    else
+                    {
+                        diag_error("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
+                        return SYNTAX_OR_LOGIC_ERROR;
+                    }
+                }
+
+                /*It is a symbol defeniton and the symbol is not exist in the symbol table*/
+                else
+                {
+                    if (line_ast->type == inst)
+                    {
+                        if (insert_symbol(&curr_program->symbol_table, line_ast->label, inst_sym, *ic, 0) == MEMORY_ALLOCATION_ERROR)
+                        {
+                            return MEMORY_ALLOCATION_ERROR;
+                        }
+                    }
+
+                    else
+                    {
+                        if (insert_symbol(&curr_program->symbol_table, line_ast->label, data_sym, *dc, 0) == MEMORY_ALLOCATION_ERROR)
+                        {
+                            return MEMORY_ALLOCATION_ERROR;
+                        }
+                    }
+                }
+            }
         }
 
-        if (line_ast.type == dir || line_ast.type == inst)
+        /*Advancing the memory counters*/
+
+        if (line_ast->type == inst)
         {
+            added_memory = (cells_hint >= 0) ? cells_hint : memory_cell_calculator(*line_ast);
+            *ic += added_memory;
+        }
 
-            /*Checking a scenario in which a label is defined (for a directive or an instruction)*/
-            if (line_ast.label[0] != '\0')
+        else
+        {
+            if (line_ast->operand.directive.type == data || line_ast->operand.directive.type == string)
             {
+                added_memory = (cells_hint >= 0) ? cells_hint : memory_cell_calculator(*line_ast);
+                *dc += added_memory;
+            }
 
-                if (macro_lookup(line_ast.label, macro_table) != NULL)
+            /*Checking a scenario of declaring a symbol as entry or extern*/
+            else if ((line_ast->operand.directive.type == entry || line_ast->operand.directive.type == ext))
+            {
+                if (macro_lookup(line_ast->operand.directive.operands.label_operand, macro_table) != NULL)
                 {
-                    printf("Error in: %s, in line number: %d , redefining a name for a macro and symbol\n", am_file_name, line_num);
-                    line_num++;
-                    err_flag = SYNTAX_OR_LOGIC_ERROR;
-                    continue;
+                    diag_error("Error in: %s, in line number: %d , redefining a name for a macro and symbol\n", am_file_name, line_num);
+                    return SYNTAX_OR_LOGIC_ERROR;
                 }
 
                 else
                 {
 
-                    sym_find = symbol_lookup(line_ast.label, curr_program->symbol_table);
+                    sym_find = symbol_lookup(line_ast->operand.directive.operands.label_operand, &curr_program->symbol_table);
 
-                    if (sym_find)
+                    if (sym_find) /*If the symbol is already exist in the symbil table*/
                     {
-                        /*if the label was previously defined as an entry, we will associate the current address with it*/
-                        if (sym_find->type == entry_sym_without_definition)
+                        if (line_ast->operand.directive.type == entry)
                         {
-                            if (line_ast.type == dir)
+                            if (sym_find->type == data_sym)
                             {
                                 sym_find->type = data_entry_sym;
-                                sym_find->address = dc;
                             }
 
-                            else
+                            else if (sym_find->type == inst_sym)
                             {
                                 sym_find->type = inst_entry_sym;
-                                sym_find->address = ic;
+                            }
+
+                            else
+                            {
+                                diag_error("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
+                                return SYNTAX_OR_LOGIC_ERROR;
                             }
                         }
 
-                        /*It was previously defined without an entry, this is a repeated definition and therefore an error */
-                        else
+                        else /*It is external and cannot be defined twice in the same file */
                         {
-                            printf("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
-                            line_num++;
-                            err_flag = SYNTAX_OR_LOGIC_ERROR;
-                            continue;
+                            diag_error("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
+                            return SYNTAX_OR_LOGIC_ERROR;
                         }
                     }
 
-                    /*It is a symbol defeniton and the symbol is not exist in the symbol table*/
-                    else
+                    else /*The symbol is not exist in the symbol table*/
                     {
-                        if (line_ast.type == inst)
+                        if (line_ast->operand.directive.type == entry)
                         {
-                            if (insert_symbol(curr_program->symbol_table, line_ast.label, inst_sym, ic, 0) == MEMORY_ALLOCATION_ERROR)
-                            {
-                                return MEMORY_ALLOCATION_ERROR;
-                            }
+                            insert_symbol(&curr_program->symbol_table, line_ast->operand.directive.operands.label_operand, entry_sym_without_definition, 0, 0);
                         }
 
                         else
                         {
-                            if (insert_symbol(curr_program->symbol_table, line_ast.label, data_sym, dc, 0) == MEMORY_ALLOCATION_ERROR)
-                            {
-                                return MEMORY_ALLOCATION_ERROR;
-                            }
+                            insert_symbol(&curr_program->symbol_table, line_ast->operand.directive.operands.label_operand, extern_sym, 0, 0);
                         }
                     }
                 }
             }
+        }
+    }
 
-            /*Advancing the memory counters*/
+    /*If it is a constant definition statement we will insert it into the symbol table if it has not already been declared*/
+    else if (line_ast->type == constant_def)
+    {
+        if (macro_lookup(line_ast->operand.constant.constant_name, macro_table) != NULL)
+        {
+            diag_error("Error in: %s , in line number: %d , redefining a name for a macro and constant\n", am_file_name, line_num);
+            return SYNTAX_OR_LOGIC_ERROR;
+        }
 
-            if (line_ast.type == inst)
+        else
+        {
+            sym_find = symbol_lookup(line_ast->operand.constant.constant_name, &curr_program->symbol_table);
+
+            if (sym_find)
             {
-                added_memory = memory_cell_calculator(line_ast);
-                ic += added_memory;
+                diag_error("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
+                return SYNTAX_OR_LOGIC_ERROR;
             }
 
             else
             {
-                if (line_ast.operand.directive.type == data || line_ast.operand.directive.type == string)
+                if (insert_symbol(&curr_program->symbol_table, line_ast->operand.constant.constant_name, const_sym, line_num, line_ast->operand.constant.constant_num) == MEMORY_ALLOCATION_ERROR)
                 {
-                    added_memory = memory_cell_calculator(line_ast);
-                    dc += added_memory;
+                    return MEMORY_ALLOCATION_ERROR;
                 }
+            }
+        }
+    }
 
-                /*Checking a scenario of declaring a symbol as entry or extern*/
-                else if ((line_ast.operand.directive.type == entry || line_ast.operand.directive.type == ext))
-                {
-                    if (macro_lookup(line_ast.operand.directive.operands.label_operand, macro_table) != NULL)
-                    {
-                        printf("Error in: %s, in line number: %d , redefining a name for a macro and symbol\n", am_file_name, line_num);
-                        line_num++;
-                        err_flag = SYNTAX_OR_LOGIC_ERROR;
-                        continue;
-                    }
+    return NO_ERRORS;
+}
 
-                    else
-                    {
+/*
+ * Function: compare_entries_by_address
+ * -------------------------------------
+ * Description:
+ *   qsort comparator ordering entry symbols by their final address, with the name as a
+ *   tie breaker so the output is deterministic.
+ *
+ * Parameters:
+ *   first: Pointer to the first SYMBOL pointer.
+ *   second: Pointer to the second SYMBOL pointer.
+ *
+ * Returns:
+ *   A negative number, zero or a positive number, as qsort expects.
+ */
 
-                        sym_find = symbol_lookup(line_ast.operand.directive.operands.label_operand, curr_program->symbol_table);
+static int compare_entries_by_address(const void *first, const void *second)
+{
+    const SYMBOL *first_sym = *(SYMBOL *const *)first;
+    const SYMBOL *second_sym = *(SYMBOL *const *)second;
 
-                        if (sym_find) /*If the symbol is already exist in the symbil table*/
-                        {
-                            if (line_ast.operand.directive.type == entry)
-                            {
-                                if (sym_find->type == data_sym)
-                                {
-                                    sym_find->type = data_entry_sym;
-                                }
-
-                                else if (sym_find->type == inst_sym)
-                                {
-                                    sym_find->type = inst_entry_sym;
-                                }
-
-                                else
-                                {
-                                    printf("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
-                                    line_num++;
-                                    err_flag = SYNTAX_OR_LOGIC_ERROR;
-                                    continue;
-                                }
-                            }
+    if (first_sym->address != second_sym->address)
+    {
+        return first_sym->address - second_sym->address;
+    }
 
-                            else /*It is external and cannot be defined twice in the same file */
-                            {
-                                printf("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
-                                line_num++;
-                                err_flag = SYNTAX_OR_LOGIC_ERROR;
-                                continue;
-                            }
-                        }
+    return strcmp(first_sym->name, second_sym->name);
+}
 
-                        else /*The symbol is not exist in the symbol table*/
-                        {
-                            if (line_ast.operand.directive.type == entry)
-                            {
-                                insert_symbol(curr_program->symbol_table, line_ast.operand.directive.operands.label_operand, entry_sym_without_definition, 0, 0);
-                            }
+/*
+ * Function: finalize_symbols
+ * ---------------------------
+ * Description:
+ *   Finishes the symbol table after all the lines were processed: reports entry symbols
+ *   that never received a value, rebases the data symbols after the instructions and
+ *   builds the name-ordered list of entry symbols.
+ *
+ * Parameters:
+ *   curr_program: Pointer to the current translation unit being processed.
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   ic: The final instruction counter, added to the address of every data symbol.
+ *
+ * Returns:
+ *   NO_ERRORS if successful, SYNTAX_OR_LOGIC_ERROR if an entry symbol has no value and
+ *   MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
 
-                            else
-                            {
-                                insert_symbol(curr_program->symbol_table, line_ast.operand.directive.operands.label_operand, extern_sym, 0, 0);
-                            }
-                        }
-                    }
-                }
-            }
-        }
+static int finalize_symbols(TRANSLATION_UNIT *curr_program, char *am_file_name, int ic)
+{
+    int err_flag = NO_ERRORS;
+    int i;
+    SYMBOL *sym_ptr;
 
-        /*If it is a constant definition statement we will insert it into the symbol table if it has not already been declared*/
-        else if (line_ast.type == constant_def)
+    for (i = 0; i < curr_program->symbol_table.capacity; i++)
+    {
+        if (curr_program->symbol_table.slots[i].name != NULL)
         {
-            if (macro_lookup(line_ast.operand.constant.constant_name, macro_table) != NULL)
+            sym_ptr = (SYMBOL *)curr_program->symbol_table.slots[i].node;
+
+            if (sym_ptr->type == entry_sym_without_definition)
             {
-                printf("Error in: %s , in line number: %d , redefining a name for a macro and constant\n", am_file_name, line_num);
-                line_num++;
+                diag_error("Error in: %s , the symbol: %s was defined as an entry but did not receive a value\n", am_file_name, sym_ptr->name);
                 err_flag = SYNTAX_OR_LOGIC_ERROR;
                 continue;
             }
 
-            else
+            if (sym_ptr->type == data_entry_sym || sym_ptr->type == data_sym)
             {
-                sym_find = symbol_lookup(line_ast.label, curr_program->symbol_table);
+                sym_ptr->address += ic;
+            }
 
-                if (sym_find)
+            /*Collecting the entry symbols into a contiguous vector; it is sorted by
+              address below, so the entries file does not depend on the layout of the
+              hash table*/
+            if (sym_ptr->type == data_entry_sym || sym_ptr->type == inst_entry_sym)
+            {
+                if (curr_program->entries_counter == curr_program->entries_capacity)
                 {
-                    printf("Error in: %s , in line number: %d , redefenition of symbol\n", am_file_name, line_num);
-                    line_num++;
-                    err_flag = SYNTAX_OR_LOGIC_ERROR;
-                    continue;
-                }
+                    SYMBOL **temp;
 
-                else
-                {
-                    if (insert_symbol(curr_program->symbol_table, line_ast.operand.constant.constant_name, const_sym, line_num, line_ast.operand.constant.constant_num) == MEMORY_ALLOCATION_ERROR)
+                    curr_program->entries_capacity = (curr_program->entries_capacity == 0) ? ENTRIES_INITIAL_CAPACITY : curr_program->entries_capacity * 2;
+                    temp = (SYMBOL **)realloc(curr_program->entries, curr_program->entries_capacity * sizeof(SYMBOL *));
+
+                    if (temp == NULL)
                     {
+                        diag_error("Error in: %s , memory allocation failed\n", am_file_name);
                         return MEMORY_ALLOCATION_ERROR;
                     }
+
+                    curr_program->entries = temp;
                 }
+
+                curr_program->entries[curr_program->entries_counter] = sym_ptr;
+                curr_program->entries_counter++;
             }
         }
+    }
 
-        line_num++;
+    /*The addresses are final here (the data symbols were just rebased), so the vector
+      is sorted once and the entries file is emitted by a single sweep over it. A file
+      without .entry directives has a NULL vector, which must not be passed to qsort*/
+    if (curr_program->entries_counter > 0)
+    {
+        qsort(curr_program->entries, curr_program->entries_counter, sizeof(SYMBOL *), compare_entries_by_address);
     }
 
-    for (i = 0; i < HASH_TABLE_SIZE; i++)
+    return err_flag;
+}
+
+/* 
+ * Function: first_pass
+ * ---------------------
+ * Description:
+ *   Performs the first pass of the assembly process. It reads each line from the assembly file,
+ *   parses it into an abstract syntax tree (AST), processes the AST to update memory counters,
+ *   and builds the symbol table. If a syntax error is encountered during processing, it prints
+ *   an error message and handles it appropriately.
+ *
+ * Parameters:
+ *   curr_program: Pointer to the current translation unit being processed.
+ *   am_buffer: The in-memory macro-expanded source produced by pre_assembly.
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *
+ * Returns:
+ *   An integer representing the success or failure of the operation.
+ *   Returns NO_ERRORS  if the operation is successful. Returns SYNTAX_OR_LOGIC_ERROR 
+ *   if a syntax or logic error is encountered during processing and MEMORY_ALLOCATION_ERROR  If memory allocation fails.
+ *
+ * Algorithm:
+ *   1. Read each line from the expanded source buffer.
+ *   2. Parse the line into an abstract syntax tree (AST).
+ *   3. Process the AST to update memory counters and build the symbol table.
+ *   4. Handle syntax errors:
+ *      - Print an error message with file name and line number.
+ *      - If memory allocation fails, return MEMORY_ALLOCATION_ERROR (-1).
+ *   5. Return appropriate status codes based on success or failure.
+ */
+
+int first_pass(TRANSLATION_UNIT *curr_program, char *am_buffer, char *am_file_name, HASH_TABLE *macro_table, AST_STREAM *ast_stream)
+{
+
+    char line[MAX_LINE_LEN];
+    char *cursor = am_buffer;
+    int ic = 100;
+    int dc = 0;
+    int err_flag = NO_ERRORS;
+    int line_num = 1;
+    int process_result;
+    LINE_AST line_ast = {0};
+
+    while (buffer_gets(line, MAX_LINE_LEN, &cursor))
     {
-        if (curr_program->symbol_table[i] != NULL)
+        /*With --quiet-after=N the error limit of the file was reached, so the rest of
+          the file is not parsed; the error status is already set*/
+        if (diag_limit_reached())
+        {
+            break;
+        }
+
+        parse_line_into(&line_ast, line);
+
+        if (line_ast.type == dir || line_ast.type == inst)
         {
-            sym_ptr = curr_program->symbol_table[i];
-            while (sym_ptr != NULL)
+            /*Keeping the parsed line so the second pass can reuse it instead of parsing the text again*/
+            if (ast_stream_append(ast_stream, &line_ast, line_num, -1) == MEMORY_ALLOCATION_ERROR)
             {
-                if (sym_ptr->type == entry_sym_without_definition)
-                {
-                    printf("Error in: %s , the symbol: %s was defined as an entry but did not receive a value\n", am_file_name, sym_ptr->name);
-                    err_flag = SYNTAX_OR_LOGIC_ERROR;
-                    continue;
-                }
+                diag_error("Error in: %s , memory allocation failed\n", am_file_name);
+                return MEMORY_ALLOCATION_ERROR;
+            }
+        }
 
-                if (sym_ptr->type == data_entry_sym || sym_ptr->type == data_sym)
-                {
-                    sym_ptr->address += ic;
-                }
+        process_result = process_parsed_line(curr_program, &line_ast, line_num, am_file_name, macro_table, &ic, &dc, -1);
 
-                /*Creating a linked list of pointers for all entry symbols*/
-                if (sym_ptr->type == data_entry_sym || sym_ptr->type == inst_entry_sym)
-                {
-                    ENTRY_NODE *new_entry = malloc(sizeof(ENTRY_NODE));
-                    if (new_entry == NULL)
-                    {
-                        printf("Error in: %s , memory allocation failed\n", am_file_name);
-                        return MEMORY_ALLOCATION_ERROR;
-                    }
+        if (process_result == MEMORY_ALLOCATION_ERROR)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
 
-                    new_entry->symbol = sym_ptr;
-                    new_entry->next = curr_program->entries_list;
-                    curr_program->entries_list = new_entry;
-                    curr_program->entries_counter++;
-                }
+        if (process_result == SYNTAX_OR_LOGIC_ERROR)
+        {
+            err_flag = SYNTAX_OR_LOGIC_ERROR;
+        }
 
-                sym_ptr = sym_ptr->next;
+        line_num++;
+    }
+
+    process_result = finalize_symbols(curr_program, am_file_name, ic);
+
+    if (process_result != NO_ERRORS)
+    {
+        return process_result;
+    }
+
+    return err_flag;
+}
+
+/*
+ * Function: first_pass_from_stream
+ * ---------------------------------
+ * Description:
+ *   Performs the first pass over an AST stream that was already parsed by the pipelined
+ *   consumer, instead of parsing the expanded source line by line. The symbol table work
+ *   is identical to first_pass; the parsing and the memory cell computation were done
+ *   while the pre-assembler was still expanding the file.
+ *
+ * Parameters:
+ *   curr_program: Pointer to the current translation unit being processed.
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   ast_stream: The stream of lines parsed by the pipelined consumer, in source order.
+ *
+ * Returns:
+ *   NO_ERRORS if the operation is successful, SYNTAX_OR_LOGIC_ERROR if a syntax or logic
+ *   error was encountered and MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int first_pass_from_stream(TRANSLATION_UNIT *curr_program, char *am_file_name, HASH_TABLE *macro_table, AST_STREAM *ast_stream)
+{
+    int ic = 100;
+    int dc = 0;
+    int err_flag = NO_ERRORS;
+    int process_result;
+    int i;
+
+    for (i = 0; i < ast_stream->count; i++)
+    {
+        /*With --quiet-after=N the error limit of the file was reached, so the rest of
+          the stream is not processed; the error status is already set*/
+        if (diag_limit_reached())
+        {
+            break;
+        }
+
+        process_result = process_parsed_line(curr_program, &ast_stream->nodes[i].ast, ast_stream->nodes[i].line_num,
+                                             am_file_name, macro_table, &ic, &dc, ast_stream->nodes[i].cells);
+
+        if (process_result == MEMORY_ALLOCATION_ERROR)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        if (process_result == SYNTAX_OR_LOGIC_ERROR)
+        {
+            err_flag = SYNTAX_OR_LOGIC_ERROR;
+        }
+    }
+
+    process_result = finalize_symbols(curr_program, am_file_name, ic);
+
+    if (process_result != NO_ERRORS)
+    {
+        return process_result;
+    }
+
+    return err_flag;
+}
+
+/*
+ * Function: single_pass
+ * ----------------------
+ * Description:
+ *   Performs the whole assembly of a file in a single traversal of the expanded source
+ *   (the --single-pass mode). Each line is parsed once, the symbol table work of the
+ *   first pass runs on it, and the line is encoded immediately: operands that cannot be
+ *   resolved yet (forward label references and constants) are recorded as fixups and
+ *   their words are left zero. After the last line, the fixups are patched from the
+ *   completed symbol table, so the second traversal of the two-pass mode is not needed
+ *   and no AST stream is kept.
+ *
+ * Parameters:
+ *   curr_program: Pointer to the current translation unit being processed.
+ *   am_buffer: The in-memory macro-expanded source produced by pre_assembly.
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *
+ * Returns:
+ *   NO_ERRORS if the operation is successful, SYNTAX_OR_LOGIC_ERROR if a syntax or logic
+ *   error was encountered and MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ *
+ * Algorithm:
+ *   1. Parse each line and run the symbol table work of the first pass on it.
+ *   2. Encode instruction and directive lines right away, recording unresolved operands
+ *      as fixups.
+ *   3. Finalize the symbol table (entry checks, data symbol rebase, entries list).
+ *   4. When the file is clean so far, patch the fixups from the completed symbol table;
+ *      unresolved fixups are the same diagnostics the second pass would have printed.
+ */
+
+int single_pass(TRANSLATION_UNIT *curr_program, char *am_buffer, char *am_file_name, HASH_TABLE *macro_table)
+{
+    char line[MAX_LINE_LEN];
+    char *cursor = am_buffer;
+    int ic = 100;
+    int dc = 0;
+    int err_flag = NO_ERRORS;
+    int line_num = 1;
+    int process_result;
+    int encode_err_flag = NO_ERRORS;
+    LINE_AST line_ast = {0};
+    FIXUP_LIST fixups = {0};
+
+    while (buffer_gets(line, MAX_LINE_LEN, &cursor))
+    {
+        /*With --quiet-after=N the error limit of the file was reached, so the rest of
+          the file is not parsed; the error status is already set*/
+        if (diag_limit_reached())
+        {
+            break;
+        }
+
+        parse_line_into(&line_ast, line);
+
+        process_result = process_parsed_line(curr_program, &line_ast, line_num, am_file_name, macro_table, &ic, &dc, -1);
+
+        if (process_result == MEMORY_ALLOCATION_ERROR)
+        {
+            free(fixups.fixups);
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        if (process_result == SYNTAX_OR_LOGIC_ERROR)
+        {
+            err_flag = SYNTAX_OR_LOGIC_ERROR;
+        }
+
+        /*The line is encoded right away; the encoding of an erroneous file is discarded
+          with the rest of the translation unit, like in the two-pass mode*/
+        if (line_ast.type == dir || line_ast.type == inst)
+        {
+            if (encode_line(curr_program, &line_ast, line_num, am_file_name, &fixups, &encode_err_flag) == MEMORY_ALLOCATION_ERROR)
+            {
+                free(fixups.fixups);
+                return MEMORY_ALLOCATION_ERROR;
             }
         }
+
+        line_num++;
     }
 
-    if (err_flag == NO_ERRORS)
+    process_result = finalize_symbols(curr_program, am_file_name, ic);
+
+    if (process_result != NO_ERRORS)
     {
-        return NO_ERRORS;
+        free(fixups.fixups);
+        return process_result;
     }
 
-    else {
-        return SYNTAX_OR_LOGIC_ERROR;
+    /*The diagnostics of unresolved fixups belong to the second pass, which the two-pass
+      mode only runs on a clean file, so a file with earlier errors stops here*/
+    if (err_flag != NO_ERRORS)
+    {
+        free(fixups.fixups);
+        return err_flag;
     }
-}
 
+    process_result = resolve_fixups(curr_program, am_file_name, &fixups);
+    free(fixups.fixups);
+    return process_result;
+}
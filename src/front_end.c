@@ -13,6 +13,7 @@
 #include <ctype.h>
 
 #include "include/front_end.h"
+#include "include/arena.h"
 
 #define MIN_12_BIT_VALUE -2048
 #define MAX_12_BIT_VALUE 2047
@@ -80,7 +81,7 @@ int is_label(char *word, int label_position)
         }
     }
 
-    word_without_suffix = (char *)malloc((word_length_without_suffix + 1) * sizeof(char));
+    word_without_suffix = (char *)arena_alloc_current((word_length_without_suffix + 1) * sizeof(char));
     if (word_without_suffix == NULL)
     {
         return MEMORY_ALLOCATION_ERROR;
@@ -98,11 +99,9 @@ int is_label(char *word, int label_position)
 
     if ((is_register(word_without_suffix) != -1) || (is_directive(word_without_suffix) != -1) || (is_operation(word_without_suffix) != -1))
     {
-        free(word_without_suffix);
         return SYNTAX_OR_LOGIC_ERROR;
     }
 
-    free(word_without_suffix);
     return NO_ERRORS;
 }
 
@@ -147,7 +146,7 @@ int is_label_with_index(char *word, INST_OPERAND *operand)
         return SYNTAX_OR_LOGIC_ERROR;
     }
 
-    label_part = (char *)malloc((index_char - word + 1) * sizeof(char));
+    label_part = (char *)arena_alloc_current((index_char - word + 1) * sizeof(char));
     if (label_part == NULL)
     {
 
@@ -161,20 +160,22 @@ int is_label_with_index(char *word, INST_OPERAND *operand)
 
     if (label_result == SYNTAX_OR_LOGIC_ERROR)
     {
-        free(label_part);
         return SYNTAX_OR_LOGIC_ERROR;
     }
 
     else if (label_result == MEMORY_ALLOCATION_ERROR)
     {
-        free(label_part);
         return MEMORY_ALLOCATION_ERROR;
     }
 
     else
     {
-        strcpy(operand->label, label_part);
-        free(label_part);
+        operand->label = intern_name(label_part);
+
+        if (operand->label == NULL)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
     }
 
     index_char++;
@@ -186,7 +187,7 @@ int is_label_with_index(char *word, INST_OPERAND *operand)
         return SYNTAX_OR_LOGIC_ERROR;
     }
 
-    index_part = (char *)malloc((closing_bracket_char - index_char + 1) * sizeof(char));
+    index_part = (char *)arena_alloc_current((closing_bracket_char - index_char + 1) * sizeof(char));
     if (index_part == NULL)
     {
         return MEMORY_ALLOCATION_ERROR;
@@ -198,7 +199,6 @@ int is_label_with_index(char *word, INST_OPERAND *operand)
     if ((index_result = is_valid_num(index_part)) != NON_VALID_NUM)
     {
         operand->num = index_result;
-        free(index_part);
         return NO_ERRORS;
     }
 
@@ -208,20 +208,23 @@ int is_label_with_index(char *word, INST_OPERAND *operand)
 
         if (index_result == NO_ERRORS)
         {
-            strcpy(operand->constant_name, index_part);
-            free(index_part);
+            operand->constant_name = intern_name(index_part);
+
+            if (operand->constant_name == NULL)
+            {
+                return MEMORY_ALLOCATION_ERROR;
+            }
+
             return NO_ERRORS;
         }
 
         else if (index_result == SYNTAX_OR_LOGIC_ERROR)
         {
-            free(index_part);
             return SYNTAX_OR_LOGIC_ERROR;
         }
 
         else
         {
-            free(index_part);
             return MEMORY_ALLOCATION_ERROR;
         }
     }
@@ -314,6 +317,42 @@ int is_valid_num(char *word)
     }
 }
 
+/*
+ * Function: stage_word
+ * ---------------------
+ * Description:
+ *   Copies the next word of the line into the stack buffer of the caller and
+ *   terminates it, without touching the allocator: the parsers only compare or convert
+ *   a word and drop it with the line, and the few names that must outlive the line are
+ *   interned (which makes its own arena copy). The buffer must hold MAX_LINE_LEN
+ *   characters, so any word of a legal line fits.
+ *
+ * Parameters:
+ *   - line: The string from which the words will be extracted, advanced past the word.
+ *   - buffer: The stack buffer of the caller receiving the terminated word.
+ *
+ * Returns:
+ *   - The buffer, or NULL at the end of the line.
+ */
+
+static char *stage_word(char **line, char *buffer)
+{
+    char *span;
+    int length;
+
+    span = get_word_span(line, &length);
+
+    if (span == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(buffer, span, length);
+    buffer[length] = '\0';
+
+    return buffer;
+}
+
 /*
  * Function: check_line_type
  * -------------------------
@@ -355,6 +394,8 @@ int is_valid_num(char *word)
 int check_line_type(char **line, LINE_AST *ast)
 {
     char *word;
+    char word_buffer[MAX_LINE_LEN];
+    char label_buffer[MAX_LABEL_LEN + 1];
     int word_cnt = 0;
     int dir_type = 0;
     int ins_type = 0;
@@ -367,7 +408,7 @@ int check_line_type(char **line, LINE_AST *ast)
 
     else
     {
-        word = get_word(line); /*get_word function skip white chars and take the next word*/
+        word = stage_word(line, word_buffer); /*skip white chars and take the next word, staged on the stack*/
 
         while (word)
         {
@@ -377,43 +418,45 @@ int check_line_type(char **line, LINE_AST *ast)
             {
                 if (word_cnt == 1)
                 {
-                    strncpy(ast->label, word, strlen(word) - 1); /*the character ';' It is not part of the label*/
-                    ast->label[strlen(word) - 1] = '\0';
+                    strncpy(label_buffer, word, strlen(word) - 1); /*the character ':' It is not part of the label*/
+                    label_buffer[strlen(word) - 1] = '\0';
+                    ast->label = intern_name(label_buffer);
+
+                    if (ast->label == NULL)
+                    {
+                        ast->error_detail = "memory allocation failed";
+                        return error;
+                    }
                 }
 
                 else
                 {
 
-                    free(word);
-                    strcpy(ast->error_detail, "a label is in an invalid place");
+                    ast->error_detail = "a label is in an invalid place";
                     return error;
                 }
             }
 
             else if (is_label_res == MEMORY_ALLOCATION_ERROR)
             {
-                free(word);
-                strcpy(ast->error_detail, "memory allocation failed");
+                ast->error_detail = "memory allocation failed";
                 return error;
             }
 
             else if ((dir_type = is_directive(word)) != -1)
             {
                 ast->operand.directive.type = dir_type;
-                free(word);
                 return dir;
             }
 
             else if ((ins_type = is_operation(word)) != -1)
             {
                 ast->operand.instruction.type = ins_type;
-                free(word);
                 return inst;
             }
 
             else if (strcmp(".define", word) == 0)
             {
-                free(word);
                 if (word_cnt == 1)
                 {
                     return constant_def;
@@ -421,7 +464,7 @@ int check_line_type(char **line, LINE_AST *ast)
 
                 else
                 {
-                    strcpy(ast->error_detail, "a label must not be defined in a constant definition line");
+                    ast->error_detail = "a label must not be defined in a constant definition line";
                     return error;
                 }
             }
@@ -430,39 +473,29 @@ int check_line_type(char **line, LINE_AST *ast)
             {
                 if (word_cnt == 1)
                 {
-                    strcpy(ast->error_detail, "the first word must be an instruction or directive or .define or label name");
+                    ast->error_detail = "the first word must be an instruction or directive or .define or label name";
                 }
 
                 else
                 {
-                    strcpy(ast->error_detail, "after defining a label there must be an instruction  or directive");
+                    ast->error_detail = "after defining a label there must be an instruction  or directive";
                 }
 
-                free(word);
                 return error;
             }
 
-            free(word);
-            word = get_word(line);
+            word = stage_word(line, word_buffer);
         }
 
-        if ((*line)[0] == '\0')
+        /*The staged words cannot fail, so reaching here means the line ended*/
+        if (word_cnt == 0)
         {
-            if (word_cnt == 0)
-            {
-                return empty;
-            }
-
-            else /*word_cnt = 1*/
-            {
-                strcpy(ast->error_detail, "the line contains only label name");
-                return error;
-            }
+            return empty;
         }
 
-        else
+        else /*word_cnt = 1*/
         {
-            strcpy(ast->error_detail, "memory allocation failed");
+            ast->error_detail = "the line contains only label name";
             return error;
         }
     }
@@ -502,6 +535,7 @@ int check_line_type(char **line, LINE_AST *ast)
 int check_dir_operand(char **line, LINE_AST *ast)
 {
     char *word;
+    char word_buffer[MAX_LINE_LEN];
     int word_len;
     int comma_cnt = 0;
     int curr_num;
@@ -511,37 +545,41 @@ int check_dir_operand(char **line, LINE_AST *ast)
 
     if ((**line) == '\0')
     {
-        strcpy(ast->error_detail, "a directive word must be followed by an operand");
+        ast->error_detail = "a directive word must be followed by an operand";
         return error;
     }
 
     if ((ast->operand.directive.type == entry) || (ast->operand.directive.type == ext))
     {
-        word = get_word(line);
+        word = stage_word(line, word_buffer);
 
         if (word == NULL)
         {
-            strcpy(ast->error_detail, "memory allocation failed");
+            ast->error_detail = "memory allocation failed";
             return error;
         }
 
         else if (is_label(word, operand_label) == MEMORY_ALLOCATION_ERROR)
         {
-            strcpy(ast->error_detail, "memory allocation failed");
-            free(word);
+            ast->error_detail = "memory allocation failed";
             return error;
         }
         else if (is_label(word, operand_label) == SYNTAX_OR_LOGIC_ERROR)
         {
-            strcpy(ast->error_detail, "an operand of entry and extern must be a proper name of a label");
-            free(word);
+            ast->error_detail = "an operand of entry and extern must be a proper name of a label";
             return error;
         }
 
         else
         {
-            strcpy(ast->operand.directive.operands.label_operand, word);
-            free(word);
+            ast->operand.directive.operands.label_operand = intern_name(word);
+
+            if (ast->operand.directive.operands.label_operand == NULL)
+            {
+                ast->error_detail = "memory allocation failed";
+                return error;
+            }
+
             return NO_ERRORS;
         }
     }
@@ -551,24 +589,24 @@ int check_dir_operand(char **line, LINE_AST *ast)
 
         if ((*line)[0] != '"')
         {
-            strcpy(ast->error_detail, "after the string directive the operand must start with the character \" ");
+            ast->error_detail = "after the string directive the operand must start with the character \" ";
             return error;
         }
 
         else
         {
             (*line)++;
-            word = get_word(line);
+            word = stage_word(line, word_buffer);
             if (word == NULL)
             {
                 if ((**line) == '\0')
                 {
-                    strcpy(ast->error_detail, "a string directive must have at least one character after the quotation marks ");
+                    ast->error_detail = "a string directive must have at least one character after the quotation marks ";
                 }
 
                 else
                 {
-                    strcpy(ast->error_detail, "memory allocation failed");
+                    ast->error_detail = "memory allocation failed";
                 }
 
                 return error;
@@ -578,8 +616,17 @@ int check_dir_operand(char **line, LINE_AST *ast)
 
             if (word[word_len - 1] != '"')
             {
-                strcpy(ast->error_detail, "in the operand of the directive string there is no closing hyphen");
-                free(word);
+                ast->error_detail = "in the operand of the directive string there is no closing hyphen";
+                return error;
+            }
+
+            /*The characters and the terminating zero live in the arena, sized to the string,
+              so the parsed line no longer embeds a fixed array*/
+            ast->operand.directive.operands.str = (int *)arena_alloc_current(word_len * sizeof(int));
+
+            if (ast->operand.directive.operands.str == NULL)
+            {
+                ast->error_detail = "memory allocation failed";
                 return error;
             }
 
@@ -592,18 +639,25 @@ int check_dir_operand(char **line, LINE_AST *ast)
 
                 else
                 {
-                    strcpy(ast->error_detail, "the operand of the string directive must include only alphabetic letters between the 2 hyphenes");
-                    free(word);
+                    ast->error_detail = "the operand of the string directive must include only alphabetic letters between the 2 hyphenes";
                     return error;
                 }
             }
-            free(word);
+
+            ast->operand.directive.operands.str[word_len - 1] = 0;
             return NO_ERRORS;
         }
     }
 
     else /*directive is .data*/
     {
+        ast->operand.directive.operands.data = (DATA *)arena_alloc_current(MAX_DATA_OPERANDS * sizeof(DATA));
+
+        if (ast->operand.directive.operands.data == NULL)
+        {
+            ast->error_detail = "memory allocation failed";
+            return error;
+        }
 
         while (((**line) != '\0') && ((**line) != EOF))
         {
@@ -616,7 +670,7 @@ int check_dir_operand(char **line, LINE_AST *ast)
             {
                 if (comma_cnt > 0)
                 {
-                    strcpy(ast->error_detail, "there are 2 commas between a number and another number");
+                    ast->error_detail = "there are 2 commas between a number and another number";
                     return error;
                 }
 
@@ -629,10 +683,10 @@ int check_dir_operand(char **line, LINE_AST *ast)
 
             else
             {
-                word = get_word(line);
+                word = stage_word(line, word_buffer);
                 if (word == NULL)
                 {
-                    strcpy(ast->error_detail, "memory allocation failed");
+                    ast->error_detail = "memory allocation failed";
                     return error;
                 }
 
@@ -648,32 +702,36 @@ int check_dir_operand(char **line, LINE_AST *ast)
                 {
                     op_cnt++;
                     ast->operand.directive.operands.data[op_cnt - 1].data_type = data_constant;
-                    strcpy(ast->operand.directive.operands.data[op_cnt - 1].data_value.constant_name, word);
+                    ast->operand.directive.operands.data[op_cnt - 1].data_value.constant_name = intern_name(word);
+
+                    if (ast->operand.directive.operands.data[op_cnt - 1].data_value.constant_name == NULL)
+                    {
+                        ast->error_detail = "memory allocation failed";
+                        return error;
+                    }
+
                     ast->operand.directive.operand_counter = op_cnt;
                 }
 
                 else if (is_label_res == MEMORY_ALLOCATION_ERROR)
                 {
-                    strcpy(ast->error_detail, "memory allocation failed");
-                    free(word);
+                    ast->error_detail = "memory allocation failed";
                     return error;
                 }
 
                 else
                 {
-                    strcpy(ast->error_detail, "for the data directive, you can only enter integers that can be represented in 12 bits by the 2's complement method or or words that meet the syntax requirements of a label");
-                    free(word);
+                    ast->error_detail = "for the data directive, you can only enter integers that can be represented in 12 bits by the 2's complement method or or words that meet the syntax requirements of a label";
                     return error;
                 }
 
-                free(word);
                 comma_cnt = 0;
             }
         }
 
         if (comma_cnt != 0)
         {
-            strcpy(ast->error_detail, "there is a comma after the last number");
+            ast->error_detail = "there is a comma after the last number";
             return error;
         }
 
@@ -708,6 +766,7 @@ int check_dir_operand(char **line, LINE_AST *ast)
 int check_inst_operand(char **line, LINE_AST *ast)
 {
     char *word;
+    char word_buffer[MAX_LINE_LEN];
     int converted_num1;
     int reg_num;
     int operand_cnt;
@@ -721,20 +780,12 @@ int check_inst_operand(char **line, LINE_AST *ast)
 
     for (; operand_cnt < MAX_INST_OPERANDS; operand_cnt++)
     {
-        word = get_word(line);
+        word = stage_word(line, word_buffer);
         if (word == NULL)
         {
-            if ((**line) == '\0')
-            {
-                strcpy(ast->error_detail, "missing operand");
-                return error;
-            }
-
-            else
-            {
-                strcpy(ast->error_detail, "memory allocation failed");
-                return error;
-            }
+            /*The staged word cannot fail, so the line ended before the operand*/
+            ast->error_detail = "missing operand";
+            return error;
         }
 
         else if (word[0] == '#')
@@ -742,15 +793,13 @@ int check_inst_operand(char **line, LINE_AST *ast)
             if (((operand_cnt == DESTINATION_OPERAND) && (ast->operand.instruction.type != cmp) && (ast->operand.instruction.type != prn)) ||
                 ((operand_cnt == SOURCE_OPERAND) && (ast->operand.instruction.type == lea)))
             {
-                strcpy(ast->error_detail, "the operation type received an operand of an inappropriate type");
-                free(word);
+                ast->error_detail = "the operation type received an operand of an inappropriate type";
                 return error;
             }
 
             else if (strlen(word) == 1)
             {
-                strcpy(ast->error_detail, "# must be followed by a number or constant");
-                free(word);
+                ast->error_detail = "# must be followed by a number or constant";
                 return error;
             }
 
@@ -766,22 +815,26 @@ int check_inst_operand(char **line, LINE_AST *ast)
             {
                 if (label_result == MEMORY_ALLOCATION_ERROR)
                 {
-                    strcpy(ast->error_detail, "memory allocation failed");
-                    free(word);
+                    ast->error_detail = "memory allocation failed";
                     return error;
                 }
 
                 else
                 {
                     ast->operand.instruction.operands[operand_cnt].type = constant;
-                    strcpy(ast->operand.instruction.operands[operand_cnt].constant_name, (word + 1));
+                    ast->operand.instruction.operands[operand_cnt].constant_name = intern_name(word + 1);
+
+                    if (ast->operand.instruction.operands[operand_cnt].constant_name == NULL)
+                    {
+                        ast->error_detail = "memory allocation failed";
+                        return error;
+                    }
                 }
             }
 
             else
             {
-                strcpy(ast->error_detail, "# must be followed by a constant or a number");
-                free(word);
+                ast->error_detail = "# must be followed by a constant or a number";
                 return error;
             }
         }
@@ -790,15 +843,20 @@ int check_inst_operand(char **line, LINE_AST *ast)
         {
             if (label_result == MEMORY_ALLOCATION_ERROR)
             {
-                strcpy(ast->error_detail, "memory allocation failed");
-                free(word);
+                ast->error_detail = "memory allocation failed";
                 return error;
             }
 
             else
             {
                 ast->operand.instruction.operands[operand_cnt].type = label;
-                strcpy(ast->operand.instruction.operands[operand_cnt].label, word);
+                ast->operand.instruction.operands[operand_cnt].label = intern_name(word);
+
+                if (ast->operand.instruction.operands[operand_cnt].label == NULL)
+                {
+                    ast->error_detail = "memory allocation failed";
+                    return error;
+                }
             }
         }
 
@@ -806,15 +864,13 @@ int check_inst_operand(char **line, LINE_AST *ast)
         {
             if (res_label_w_index == MEMORY_ALLOCATION_ERROR)
             {
-                strcpy(ast->error_detail, "memory allocation failed");
-                free(word);
+                ast->error_detail = "memory allocation failed";
                 return error;
             }
 
             else if ((operand_cnt == DESTINATION_OPERAND) && ((ast->operand.instruction.type == jmp) || (ast->operand.instruction.type == bne) || (ast->operand.instruction.type == jsr)))
             {
-                free(word);
-                strcpy(ast->error_detail, "the operation type received an operand of an inappropriate type");
+                ast->error_detail = "the operation type received an operand of an inappropriate type";
                 return error;
             }
 
@@ -829,8 +885,7 @@ int check_inst_operand(char **line, LINE_AST *ast)
         {
             if ((operand_cnt == SOURCE_OPERAND) && (ast->operand.instruction.type == lea))
             {
-                strcpy(ast->error_detail, "the operation type received an operand of an inappropriate type");
-                free(word);
+                ast->error_detail = "the operation type received an operand of an inappropriate type";
                 return error;
             }
             else
@@ -843,12 +898,10 @@ int check_inst_operand(char **line, LINE_AST *ast)
 
         else
         {
-            free(word);
-            strcpy(ast->error_detail, "the operation type received an operand of an inappropriate type");
+            ast->error_detail = "the operation type received an operand of an inappropriate type";
             return error;
         }
 
-        free(word);
 
         if (operand_cnt == SOURCE_OPERAND)
         {
@@ -858,7 +911,7 @@ int check_inst_operand(char **line, LINE_AST *ast)
                 {
                     if (comma_flag > 0)
                     {
-                        strcpy(ast->error_detail, "multiple commas between 2 operands");
+                        ast->error_detail = "multiple commas between 2 operands";
                         return error;
                     }
 
@@ -873,7 +926,7 @@ int check_inst_operand(char **line, LINE_AST *ast)
 
             if ((**line) == '\0')
             {
-                strcpy(ast->error_detail, "missing operand");
+                ast->error_detail = "missing operand";
                 return error;
             }
         }
@@ -907,40 +960,44 @@ int check_inst_operand(char **line, LINE_AST *ast)
 int check_constant_def_operand(char **line, LINE_AST *ast)
 {
     char *word;
+    char word_buffer[MAX_LINE_LEN];
     int converted_num;
     int is_label_res;
 
     if ((**line) == '\0')
     {
-        strcpy(ast->error_detail, "a constant definition is missing after the word define");
+        ast->error_detail = "a constant definition is missing after the word define";
         return error;
     }
 
-    word = get_word(line);
+    word = stage_word(line, word_buffer);
     if (word == NULL)
     {
-        strcpy(ast->error_detail, "memory allocation failed");
+        ast->error_detail = "memory allocation failed";
         return error;
     }
 
     else if ((is_label_res = is_label(word, operand_label)) == SYNTAX_OR_LOGIC_ERROR)
     {
-        strcpy(ast->error_detail, "the first word after .define does not follow the syntax rules for a label");
-        free(word);
+        ast->error_detail = "the first word after .define does not follow the syntax rules for a label";
         return error;
     }
 
     else if (is_label_res == MEMORY_ALLOCATION_ERROR)
     {
-        strcpy(ast->error_detail, "memory allocation failed");
-        free(word);
+        ast->error_detail = "memory allocation failed";
         return error;
     }
 
     else
     {
-        strcpy(ast->operand.constant.constant_name, word);
-        free(word);
+        ast->operand.constant.constant_name = intern_name(word);
+
+        if (ast->operand.constant.constant_name == NULL)
+        {
+            ast->error_detail = "memory allocation failed";
+            return error;
+        }
     }
 
     while (isspace(**line))
@@ -950,7 +1007,7 @@ int check_constant_def_operand(char **line, LINE_AST *ast)
 
     if ((**line) != '=')
     {
-        strcpy(ast->error_detail, "missing the equality sign in a constant definition statment");
+        ast->error_detail = "missing the equality sign in a constant definition statment";
         return error;
     }
 
@@ -963,27 +1020,25 @@ int check_constant_def_operand(char **line, LINE_AST *ast)
 
     if ((**line) == '\0')
     {
-        strcpy(ast->error_detail, "missing a  number in a constant definition statement");
+        ast->error_detail = "missing a  number in a constant definition statement";
         return error;
     }
 
-    word = get_word(line);
+    word = stage_word(line, word_buffer);
 
     if (word == NULL)
     {
-        strcpy(ast->error_detail, "memory allocation failed");
+        ast->error_detail = "memory allocation failed";
         return error;
     }
 
     if ((converted_num = is_valid_num(word)) == NON_VALID_NUM)
     {
-        strcpy(ast->error_detail, "a no valid number is given in a constant definition statement");
-        free(word);
+        ast->error_detail = "a no valid number is given in a constant definition statement";
         return error;
     }
 
     ast->operand.constant.constant_num = converted_num;
-    free(word);
     return NO_ERRORS;
 }
 
@@ -1022,7 +1077,7 @@ int check_operand(char **line, LINE_AST *ast)
 
     if ((**line) == ',')
     {
-        strcpy(ast->error_detail, "there is a comma, after an instruction/directive/define");
+        ast->error_detail = "there is a comma, after an instruction/directive/define";
         return error;
     }
 
@@ -1059,7 +1114,7 @@ int check_operand(char **line, LINE_AST *ast)
 
     if ((**line) != '\0')
     {
-        strcpy(ast->error_detail, "unexpected characters after operands");
+        ast->error_detail = "unexpected characters after operands";
         syntax_flag = error;
     }
 
@@ -1067,44 +1122,62 @@ int check_operand(char **line, LINE_AST *ast)
 }
 
 /*
- * Function: create_ast_from_text
- * ------------------------------
+ * Function: parse_line_into
+ * --------------------------
  * Description:
- *   Creates an abstract syntax tree (AST) for a line of assembly code.
+ *   Parses a line of assembly code into the given LINE_AST slot. The passes reuse one
+ *   slot per loop, so parsing a line does not copy the structure out of the parser.
  *
  * Parameters:
+ *   ast: The slot receiving the parsed line.
  *   line: The line of assembly code.
  *
- * Returns:
- *   An abstract syntax tree (AST) structure representing the line of assembly code.
- *
  * Algorithm:
- *   1. Initialize the syntax flag.
- *   2. Create an empty AST structure.
- *   3. Check the type of line and parse it accordingly.
- *   4. Check the operands of the line.
- *   5. If there is an error in the operands, set the AST type to error.
- *   6. Return the AST structure.
+ *   1. Clear the slot.
+ *   2. Check the type of line and parse it accordingly.
+ *   3. Check the operands of the line.
+ *   4. If there is an error in the operands, set the AST type to error.
  */
 
-LINE_AST create_ast_from_text(char *line)
+void parse_line_into(LINE_AST *ast, char *line)
 {
     int syntax_flag = -1;
-    LINE_AST ast = {0};
 
-    ast.type = check_line_type(&line, &ast);
-    if (strcmp(ast.error_detail, "memory allocation failed") == 0)
+    memset(ast, 0, sizeof(LINE_AST));
+
+    ast->type = check_line_type(&line, ast);
+    if ((ast->error_detail != NULL) && (strcmp(ast->error_detail, "memory allocation failed") == 0))
     {
-        return ast;
+        return;
     }
 
-    syntax_flag = check_operand(&line, &ast);
+    syntax_flag = check_operand(&line, ast);
 
     if (syntax_flag == error)
     {
-        ast.type = error;
+        ast->type = error;
     }
+}
+
+/*
+ * Function: create_ast_from_text
+ * ------------------------------
+ * Description:
+ *   Creates an abstract syntax tree (AST) for a line of assembly code. Convenience
+ *   wrapper around parse_line_into for callers that want the structure by value.
+ *
+ * Parameters:
+ *   line: The line of assembly code.
+ *
+ * Returns:
+ *   An abstract syntax tree (AST) structure representing the line of assembly code.
+ */
+
+LINE_AST create_ast_from_text(char *line)
+{
+    LINE_AST ast;
 
+    parse_line_into(&ast, line);
     return ast;
 }
 
@@ -4,104 +4,211 @@
 #include <stdio.h>
 
 #include "include/general.h"
+#include "include/arena.h"
+#include "include/profile.h"
+#include <pthread.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Function: free_ext_refs
+ * -----------------------
+ * Description:
+ *   Releases the vector of external references of a translation unit.
+ *
+ * Parameters:
+ *   curr_program: The translation unit whose reference vector should be freed.
+ */
+
+void free_ext_refs(TRANSLATION_UNIT *curr_program)
+{
+    free(curr_program->ext_refs);
+    curr_program->ext_refs = NULL;
+    curr_program->external_counter = 0;
+    curr_program->ext_refs_capacity = 0;
+}
 
 /*
- * Function: free_ext_list
+ * Function: free_entries
+ * ----------------------
+ * Description:
+ *   Releases the vector of entry symbol pointers of a translation unit (the symbols are
+ *   owned by the per-file arena).
+ *
+ * Parameters:
+ *   curr_program: The translation unit whose entry vector should be freed.
+ */
+
+void free_entries(TRANSLATION_UNIT *curr_program)
+{
+    free(curr_program->entries);
+    curr_program->entries = NULL;
+    curr_program->entries_counter = 0;
+    curr_program->entries_capacity = 0;
+}
+
+/*
+ * Function: free_symbol_table
  * -----------------------------------
  * Description:
- *   Frees the memory allocated for the linked list of external symbols.
+ *   Frees the symbol table and resets it to empty.
  * Parameters:
- *   - head: Pointer to the head of the linked list of external symbols.
+ *   - symbol_table: The symbol table for which the allocated memory should be freed.
  * Returns: None
  * Algorithm:
- *   - Iterate through the linked list of external symbols.
- *   - For each symbol, iterate through its associated addresses and free them.
- *   - Free the external symbol node itself.
+ *   - The symbol nodes are owned by the per-file arena and are released with it in one
+ *     shot, so only the slot array of the table itself is freed.
  */
 
-void free_ext_list(EXT_SYMBOL **head)
+void free_symbol_table(HASH_TABLE *symbol_table)
 {
-    EXT_SYMBOL *current = *head;
-    EXT_SYMBOL *temp;
-    EXT_ADDRESS *address_current;
-    EXT_ADDRESS *address_temp;
-
-    while (current != NULL)
-    {
-        temp = current;
-        current = current->next_ext;
+    free_hash_table(symbol_table);
+}
 
-        /*Free the linked list of addresses for each external symbol*/
-        address_current = temp->address;
-        while (address_current != NULL)
-        {
-            address_temp = address_current;
-            address_current = address_current->next_address;
-            free(address_temp);
-        }
+/*
+ * Function: memory_image_bytes
+ * -----------------------------------
+ * Description:
+ *   Computes the allocation size of a bit-packed image holding the given number of
+ *   14-bit words. Two guard bytes are added so the three-byte accesses of the last
+ *   word stay inside the allocation.
+ * Parameters:
+ *   - word_capacity: The number of words.
+ * Returns:
+ *   - The number of bytes to allocate.
+ */
 
-        temp->address = NULL;
-        /*Free the external symbol node*/
-        free(temp);
-    }
+static long memory_image_bytes(int word_capacity)
+{
+    return (((long)word_capacity * 14 + 7) / 8) + 2;
 }
 
 /*
- * Function: free_entries_list
+ * Function: memory_image_reserve
  * -----------------------------------
  * Description:
- *   Frees the memory allocated for a linked list of entry symbol pointers.
+ *   Makes sure a memory image has at least the requested number of words.
  * Parameters:
- *   - head: A pointer to the head of the linked list of entry nodes.
- * Returns: None
+ *   - image: The memory image to grow.
+ *   - needed_capacity: The number of words the caller is about to address.
+ * Returns:
+ *   - NO_ERRORS if the room is available, MEMORY_ALLOCATION_ERROR if memory allocation fails.
  * Algorithm:
- *   - Iterate through the linked list of entry nodes.
- *   - Free each node.
+ *   - Double the capacity until the requested number of words fits, reallocate the
+ *     packed byte buffer and zero-fill the new bytes, so freshly reserved words read
+ *     as zero and can be encoded with memory_image_or.
  */
 
-void free_entries_list(ENTRY_NODE *head)
+int memory_image_reserve(MEMORY_IMAGE *image, int needed_capacity)
 {
-    ENTRY_NODE *temp;
-    while (head != NULL)
+    int new_capacity;
+    long old_bytes;
+    long new_bytes;
+    unsigned char *temp;
+
+    if (needed_capacity <= image->capacity)
     {
-        temp = head;
-        head = head->next;
-        free(temp);
+        return NO_ERRORS;
     }
+
+    new_capacity = (image->capacity == 0) ? MEMORY_IMAGE_INITIAL_CAPACITY : image->capacity;
+
+    while (new_capacity < needed_capacity)
+    {
+        new_capacity *= 2;
+    }
+
+    old_bytes = (image->bytes == NULL) ? 0 : memory_image_bytes(image->capacity);
+    new_bytes = memory_image_bytes(new_capacity);
+    temp = (unsigned char *)realloc(image->bytes, new_bytes);
+
+    if (temp == NULL)
+    {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    memset(temp + old_bytes, 0, new_bytes - old_bytes);
+    image->bytes = temp;
+    image->capacity = new_capacity;
+    return NO_ERRORS;
 }
 
 /*
- * Function: free_symbol_table
- * -----------------------------------
+ * Function: memory_image_or
+ * -------------------------
  * Description:
- *   Frees the symbol table and initializes it to NULL.
+ *   ORs the low 14 bits of a value into the word at the given index of a bit-packed
+ *   memory image.
  * Parameters:
- *   - symbol_table: The symbol table for which the allocated memory should be freed.
- * Returns: None
+ *   - image: The memory image to encode into.
+ *   - index: The index of the word, below the reserved capacity.
+ *   - value: The bits to OR into the word (only the low 14 bits are kept).
  * Algorithm:
- *   - Iterate through each hash table entry.
- *   - For each entry, iterate through the linked list of symbols and free each node.
- *   - Set the hash table entry to NULL after freeing all nodes.
+ *   - The word starts at bit 14 * index of the byte buffer; its bits span at most three
+ *     bytes, which are read, ORed and written back in little-endian bit order.
  */
 
-void free_symbol_table(SYMBOL **symbol_table)
+void memory_image_or(MEMORY_IMAGE *image, int index, int value)
 {
-    int i;
-    SYMBOL *curr_symbol;
-    SYMBOL *temp;
+    long bit_offset = (long)index * 14;
+    long byte_offset = bit_offset >> 3;
+    int shift = (int)(bit_offset & 7);
+    unsigned long chunk;
 
-    for (i = 0; i < HASH_TABLE_SIZE; i++)
-    {
-        curr_symbol = symbol_table[i];
-        while (curr_symbol != NULL)
-        {
-            temp = curr_symbol;
-            curr_symbol = curr_symbol->next;
-            free(temp);
-        }
-        /*Set the hash table entry to NULL after freeing all nodes*/
-        symbol_table[i] = NULL;
-    }
+    chunk = (unsigned long)image->bytes[byte_offset] |
+            ((unsigned long)image->bytes[byte_offset + 1] << 8) |
+            ((unsigned long)image->bytes[byte_offset + 2] << 16);
+
+    chunk |= ((unsigned long)value & 0x3FFF) << shift;
+
+    image->bytes[byte_offset] = (unsigned char)(chunk & 0xFF);
+    image->bytes[byte_offset + 1] = (unsigned char)((chunk >> 8) & 0xFF);
+    image->bytes[byte_offset + 2] = (unsigned char)((chunk >> 16) & 0xFF);
+}
+
+/*
+ * Function: memory_image_get
+ * --------------------------
+ * Description:
+ *   Reads the 14-bit word at the given index of a bit-packed memory image.
+ * Parameters:
+ *   - image: The memory image to read from.
+ *   - index: The index of the word, below the reserved capacity.
+ * Returns:
+ *   - The word, as a non-negative value below 1 << 14.
+ */
+
+int memory_image_get(MEMORY_IMAGE *image, int index)
+{
+    long bit_offset = (long)index * 14;
+    long byte_offset = bit_offset >> 3;
+    int shift = (int)(bit_offset & 7);
+    unsigned long chunk;
+
+    chunk = (unsigned long)image->bytes[byte_offset] |
+            ((unsigned long)image->bytes[byte_offset + 1] << 8) |
+            ((unsigned long)image->bytes[byte_offset + 2] << 16);
+
+    return (int)((chunk >> shift) & 0x3FFF);
+}
+
+/*
+ * Function: free_memory_image
+ * -----------------------------------
+ * Description:
+ *   Frees the packed byte buffer of a memory image and resets it to empty.
+ * Parameters:
+ *   - image: The memory image whose allocated memory should be freed.
+ * Returns: None
+ */
+
+void free_memory_image(MEMORY_IMAGE *image)
+{
+    free(image->bytes);
+    image->bytes = NULL;
+    image->capacity = 0;
 }
 
 /*
@@ -115,7 +222,8 @@ void free_symbol_table(SYMBOL **symbol_table)
  * Returns:
  *   - The connected string if memory allocation was successful, NULL otherwise.
  * Algorithm:
- *   - Allocate memory for the concatenated string based on the lengths of the input strings.
+ *   - Allocate memory for the concatenated string from the per-file arena, based on the
+ *     lengths of the input strings.
  *   - Copy the content of the original string to the new string.
  *   - Concatenate the second string to the new string.
  *   - Return the connected string.
@@ -128,7 +236,9 @@ char *dynamic_strcat(char *first_string, char *second_string)
 
     connected_string_size = (strlen(first_string) + strlen(second_string) + 1);
 
-    connected_string = (char *)malloc(connected_string_size * sizeof(char));
+    profile_count_alloc(profile_alloc_dynamic_strcat);
+
+    connected_string = (char *)arena_alloc_current(connected_string_size * sizeof(char));
     if (connected_string == NULL)
     {
         printf("Error in: %s , memory allocation failed \n", first_string);
@@ -142,48 +252,356 @@ char *dynamic_strcat(char *first_string, char *second_string)
 }
 
 /*
- * Function: symbol_lookup
+ * Function: buffer_gets
  * -----------------------------------
  * Description:
- *   Looks up a node in a hash table based on the provided name.
+ *   Reads the next line from an in-memory source buffer, mirroring the behavior of fgets.
  * Parameters:
- *   - name: The name to be looked up in the hash table.
- *   - hash_table: An array of pointers to nodes representing the hash table.
+ *   - dest: The destination array into which the line is copied.
+ *   - max_len: The size of the destination array.
+ *   - cursor: Pointer to the current reading position inside the buffer, advanced past the line that was read.
+ * Returns:
+ *   - dest if a line was read, or NULL if the end of the buffer was reached.
+ * Algorithm:
+ *   - Copy characters from the cursor position into dest until a newline, the end of the
+ *     buffer, or max_len - 1 characters were copied (the newline itself is kept, as in fgets).
+ *   - Null-terminate dest and advance the cursor past the copied characters.
+ */
+
+char *buffer_gets(char *dest, int max_len, char **cursor)
+{
+    int i = 0;
+
+    if ((**cursor) == '\0')
+    {
+        return NULL;
+    }
+
+    while ((i < max_len - 1) && ((**cursor) != '\0'))
+    {
+        dest[i] = **cursor;
+        (*cursor)++;
+        i++;
+
+        if (dest[i - 1] == '\n')
+        {
+            break;
+        }
+    }
+
+    dest[i] = '\0';
+    return dest;
+}
+
+/*
+ * Function: hash_table_lookup
+ * -----------------------------------
+ * Description:
+ *   Looks up a node in an open-addressing hash table based on the provided name.
+ * Parameters:
+ *   - table: The hash table to search.
+ *   - name: The name to be looked up.
  * Returns:
  *   - A pointer to the found node if it exists, or NULL if the node is not found.
  * Algorithm:
  *   - Calculate the hash value for the provided name using the djb2 algorithm.
- *   - Traverse the linked list at the corresponding hash index to find the matching node.
- *   - Return the pointer to the found node, or NULL if not found.
+ *   - Probe linearly from the masked hash index until an empty slot is reached.
+ *   - Compare the stored hash of each occupied slot first, and only call strcmp when
+ *     the hashes match, so most probe steps cost one integer comparison.
  */
 
-SYMBOL *symbol_lookup(char *name, SYMBOL *hash_table[HASH_TABLE_SIZE])
+void *hash_table_lookup(HASH_TABLE *table, char *name)
 {
-    unsigned int index = hash(name);
-    SYMBOL *current = hash_table[index];
-    while (current != NULL)
+    unsigned int hash_value;
+    int index;
+
+    if (profile_enabled && table->shared == 0)
+    {
+        table->lookups++;
+    }
+
+    if (table->slots == NULL)
+    {
+        return NULL;
+    }
+
+    hash_value = hash(name);
+    index = hash_value & (table->capacity - 1);
+
+    while (table->slots[index].name != NULL)
+    {
+        if (profile_enabled && table->shared == 0)
+        {
+            table->probes++;
+        }
+
+        if ((table->slots[index].hash == hash_value) && (strcmp(name, table->slots[index].name) == 0))
+        {
+            return table->slots[index].node;
+        }
+
+        index = (index + 1) & (table->capacity - 1);
+    }
+
+    return NULL;
+}
+
+/*
+ * Function: hash_table_lookup_interned
+ * ------------------------------------
+ * Description:
+ *   Looks up a node in a hash table whose names are all interned. Since equal interned
+ *   names are the same pointer, every probe is a single pointer comparison instead of
+ *   a stored-hash check followed by strcmp.
+ *
+ * Parameters:
+ *   table: The hash table to search.
+ *   name: The interned name to be looked up.
+ *
+ * Returns:
+ *   A pointer to the found node if it exists, or NULL if the node is not found.
+ */
+
+void *hash_table_lookup_interned(HASH_TABLE *table, char *name)
+{
+    int index;
+
+    if (profile_enabled && table->shared == 0)
+    {
+        table->lookups++;
+    }
+
+    if (table->slots == NULL)
+    {
+        return NULL;
+    }
+
+    index = hash(name) & (table->capacity - 1);
+
+    while (table->slots[index].name != NULL)
     {
-        if (strcmp(name, current->name) == 0)
+        if (profile_enabled && table->shared == 0)
+        {
+            table->probes++;
+        }
+
+        if (table->slots[index].name == name)
         {
-            return current;
+            return table->slots[index].node;
         }
-        current = current->next;
+
+        index = (index + 1) & (table->capacity - 1);
     }
+
     return NULL;
 }
 
+static pthread_key_t current_intern_pool_key;
+static pthread_once_t current_intern_pool_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Function: create_current_intern_pool_key
+ * -----------------------------------------
+ * Description:
+ *   Creates the thread-specific key holding the interning pool of the file the thread
+ *   is processing. Executed exactly once through pthread_once.
+ */
+
+static void create_current_intern_pool_key(void)
+{
+    pthread_key_create(&current_intern_pool_key, NULL);
+}
+
+/*
+ * Function: intern_set_current
+ * -----------------------------
+ * Description:
+ *   Installs the interning pool of the file the calling thread is processing, so the
+ *   parsing code can intern names without threading the pool through every call.
+ *
+ * Parameters:
+ *   pool: The hash table holding the interned names of the file, or NULL to remove it.
+ */
+
+void intern_set_current(HASH_TABLE *pool)
+{
+    pthread_once(&current_intern_pool_once, create_current_intern_pool_key);
+    pthread_setspecific(current_intern_pool_key, pool);
+}
+
+/*
+ * Function: intern_name
+ * ----------------------
+ * Description:
+ *   Returns the single canonical copy of the given name. The first occurrence of a name
+ *   is copied into the per-file arena and recorded in the interning pool; every later
+ *   occurrence returns the same pointer, so interned names can be compared by pointer
+ *   and each unique name is stored exactly once no matter how often it appears.
+ *
+ * Parameters:
+ *   name: The name to intern.
+ *
+ * Returns:
+ *   The canonical copy of the name, or NULL if memory allocation fails or no pool is
+ *   installed.
+ */
+
+char *intern_name(char *name)
+{
+    HASH_TABLE *pool;
+    char *interned;
+    int name_length;
+
+    pthread_once(&current_intern_pool_once, create_current_intern_pool_key);
+    pool = (HASH_TABLE *)pthread_getspecific(current_intern_pool_key);
+
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    interned = (char *)hash_table_lookup(pool, name);
+
+    if (interned != NULL)
+    {
+        return interned;
+    }
+
+    name_length = strlen(name);
+    interned = (char *)arena_alloc_current((name_length + 1) * sizeof(char));
+
+    if (interned == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(interned, name, name_length + 1);
+
+    if (hash_table_insert(pool, interned, interned) == MEMORY_ALLOCATION_ERROR)
+    {
+        return NULL;
+    }
+
+    return interned;
+}
+
+/*
+ * Function: hash_table_insert
+ * -----------------------------------
+ * Description:
+ *   Inserts a node under the provided name into an open-addressing hash table.
+ * Parameters:
+ *   - table: The hash table to insert into.
+ *   - name: The name under which the node is stored (not copied, must outlive the table).
+ *   - node: The node to store.
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ * Algorithm:
+ *   - When the table is missing or three quarters full, allocate a slot array twice as
+ *     large and reinsert the occupied slots (their stored hashes are reused, so the
+ *     names are not hashed or compared again).
+ *   - Probe linearly from the masked hash index to the first empty slot and fill it.
+ */
+
+int hash_table_insert(HASH_TABLE *table, char *name, void *node)
+{
+    HASH_SLOT *new_slots;
+    unsigned int hash_value;
+    int new_capacity;
+    int index;
+    int i;
+
+    if ((table->slots == NULL) || (table->count * 4 >= table->capacity * 3))
+    {
+        new_capacity = (table->slots == NULL) ? HASH_TABLE_INITIAL_CAPACITY : table->capacity * 2;
+        new_slots = (HASH_SLOT *)calloc(new_capacity, sizeof(HASH_SLOT));
+
+        if (new_slots == NULL)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        for (i = 0; i < table->capacity; i++)
+        {
+            if (table->slots[i].name != NULL)
+            {
+                index = table->slots[i].hash & (new_capacity - 1);
+
+                while (new_slots[index].name != NULL)
+                {
+                    index = (index + 1) & (new_capacity - 1);
+                }
+
+                new_slots[index] = table->slots[i];
+            }
+        }
+
+        free(table->slots);
+        table->slots = new_slots;
+        table->capacity = new_capacity;
+    }
+
+    hash_value = hash(name);
+    index = hash_value & (table->capacity - 1);
+
+    while (table->slots[index].name != NULL)
+    {
+        index = (index + 1) & (table->capacity - 1);
+    }
+
+    table->slots[index].hash = hash_value;
+    table->slots[index].name = name;
+    table->slots[index].node = node;
+    table->count++;
+
+    return NO_ERRORS;
+}
+
+/*
+ * Function: free_hash_table
+ * -----------------------------------
+ * Description:
+ *   Frees the slot array of an open-addressing hash table and resets it to empty.
+ * Parameters:
+ *   - table: The hash table to free.
+ */
+
+void free_hash_table(HASH_TABLE *table)
+{
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+    table->count = 0;
+}
+
+/*
+ * Function: symbol_lookup
+ * -----------------------------------
+ * Description:
+ *   Looks up a symbol in the symbol table based on the provided name.
+ * Parameters:
+ *   - name: The name to be looked up in the symbol table.
+ *   - symbol_table: The open-addressing symbol table.
+ * Returns:
+ *   - A pointer to the found symbol if it exists, or NULL if the symbol is not found.
+ */
+
+SYMBOL *symbol_lookup(char *name, HASH_TABLE *symbol_table)
+{
+    return (SYMBOL *)hash_table_lookup_interned(symbol_table, name);
+}
+
 /*
  * Function: hash
  * -----------------------------------
  * Description:
- *   Allocates for a name, index in the hash table.
+ *   Calculates the hash value of a name.
  * Parameters:
  *   - name: The name for which to calculate the hash value.
  * Returns:
- *   - The index in the hash table.
+ *   - The full hash value (the table index is derived from it with a bit mask).
  * Algorithm:
  *   - Calculate the hash value for the provided name using the djb2 algorithm.
- *   - Return the index in the hash table.
  */
 
 unsigned int hash(char *name)
@@ -195,7 +613,155 @@ unsigned int hash(char *name)
         hash_value = ((hash_value << 5) + hash_value) + *name; /*hash * 33 + c*/
     }
 
-    return hash_value % HASH_TABLE_SIZE;
+    return hash_value;
+}
+
+
+#ifdef __SSE2__
+
+/*
+ * Function: separator_mask
+ * -------------------------
+ * Description:
+ *   Classifies 16 bytes at once, returning a bit mask with a set bit for every byte
+ *   that separates tokens: the six whitespace characters of the C locale or a comma.
+ * Parameters:
+ *   - block: 16 input bytes.
+ * Returns:
+ *   - A 16-bit mask, bit i set when byte i is a separator.
+ */
+
+static int separator_mask(__m128i block)
+{
+    __m128i separators;
+
+    separators = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    separators = _mm_or_si128(separators, _mm_cmpeq_epi8(block, _mm_set1_epi8('\t')));
+    separators = _mm_or_si128(separators, _mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+    separators = _mm_or_si128(separators, _mm_cmpeq_epi8(block, _mm_set1_epi8('\v')));
+    separators = _mm_or_si128(separators, _mm_cmpeq_epi8(block, _mm_set1_epi8('\f')));
+    separators = _mm_or_si128(separators, _mm_cmpeq_epi8(block, _mm_set1_epi8('\r')));
+    separators = _mm_or_si128(separators, _mm_cmpeq_epi8(block, _mm_set1_epi8(',')));
+
+    return _mm_movemask_epi8(separators);
+}
+
+/*
+ * Function: first_set_bit
+ * ------------------------
+ * Description:
+ *   Returns the index of the lowest set bit of a non-zero mask.
+ * Parameters:
+ *   - mask: The mask to scan, must not be zero.
+ * Returns:
+ *   - The index of the lowest set bit.
+ */
+
+static int first_set_bit(int mask)
+{
+    int index = 0;
+
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        index++;
+    }
+
+    return index;
+}
+
+#endif
+
+/*
+ * Function: skip_separators
+ * --------------------------
+ * Description:
+ *   Advances over the whitespace and commas that separate tokens, stopping at the first
+ *   other character or at the end of the string. With SSE2 the bytes are classified 16
+ *   at a time through aligned loads (which never cross a page boundary), so the scan is
+ *   no longer one branch per input byte; without it a scalar loop does the same.
+ * Parameters:
+ *   - cursor: Position to scan from.
+ * Returns:
+ *   - The position of the first character that is not a separator.
+ */
+
+static char *skip_separators(char *cursor)
+{
+#ifdef __SSE2__
+    const __m128i *block;
+    int offset;
+    int mask;
+
+    block = (const __m128i *)((unsigned long)cursor & ~15UL);
+    offset = cursor - (const char *)block;
+
+    /*Bytes that are neither separators nor before the cursor; the terminating null
+      is such a byte, so the scan always stops inside the string*/
+    mask = (~separator_mask(_mm_load_si128(block)) & 0xFFFF) >> offset;
+
+    while (mask == 0)
+    {
+        block++;
+        offset = 0;
+        mask = ~separator_mask(_mm_load_si128(block)) & 0xFFFF;
+    }
+
+    return (char *)block + offset + first_set_bit(mask);
+#else
+    while (isspace(*cursor) || (*cursor) == ',')
+    {
+        cursor++;
+    }
+
+    return cursor;
+#endif
+}
+
+/*
+ * Function: find_word_end
+ * ------------------------
+ * Description:
+ *   Scans from the first character of a word to the separator or end of string that
+ *   terminates it. With SSE2 the bytes are classified 16 at a time; without it a scalar
+ *   loop does the same.
+ * Parameters:
+ *   - cursor: The first character of the word.
+ * Returns:
+ *   - The position of the first separator or terminating null after the word.
+ */
+
+static char *find_word_end(char *cursor)
+{
+#ifdef __SSE2__
+    const __m128i *block;
+    __m128i bytes;
+    int offset;
+    int mask;
+
+    block = (const __m128i *)((unsigned long)cursor & ~15UL);
+    offset = cursor - (const char *)block;
+
+    bytes = _mm_load_si128(block);
+    mask = (separator_mask(bytes) | _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()))) >> offset;
+
+    while (mask == 0)
+    {
+        block++;
+        offset = 0;
+        bytes = _mm_load_si128(block);
+        mask = separator_mask(bytes) | _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+    }
+
+    return (char *)block + offset + first_set_bit(mask);
+#else
+    while (*cursor && !isspace(*cursor) && (*cursor) != ',')
+    {
+        cursor++;
+    }
+
+    return cursor;
+#endif
 }
 
 /*
@@ -208,66 +774,94 @@ unsigned int hash(char *name)
  * Returns:
  *   - The next word in the string, or NULL in case of end of string or memory allocation error.
  * Algorithm:
- *   - Skip leading whitespace and commas.
- *   - Allocate memory for the word.
- *   - Extract characters for the word until whitespace, comma, or end of string is encountered.
- *   - Null-terminate the word and return it.
+ *   - Skip leading whitespace and commas (16 bytes at a time on SSE2 machines).
+ *   - Scan ahead to measure the word, so its copy is allocated exactly once from the
+ *     per-file arena (callers must not free it, the arena is released per file).
+ *   - Copy the word, null-terminate it and return it.
  */
 
 char *get_word(char **line)
 {
     char *word = NULL;
-    char *temp = NULL;
-    int word_length = STANDARD_WORD_SIZE;
-    int char_cnt = 0;
+    char *span;
+    int word_length;
 
-    /*Skip leading whitespace*/
-    while (isspace(**line) || (**line) == ',')
-    {
-        (*line)++;
-    }
+    span = get_word_span(line, &word_length);
 
-    /*Check for the end of the line*/
-    if (**line == '\0')
+    if (span == NULL)
     {
         return NULL; /*No more words*/
     }
 
-    /*Allocate memory for the word*/
-    word = (char *)malloc(word_length * sizeof(char));
+    profile_count_alloc(profile_alloc_get_word);
+
+    word = (char *)arena_alloc_current((word_length + 1) * sizeof(char));
 
     if (word == NULL)
     {
         return NULL;
     }
 
-    /*Extract characters for the word*/
-    while (**line && !isspace(**line) && (**line) != ',')
-    {
+    memcpy(word, span, word_length * sizeof(char));
+    word[word_length] = '\0';
 
-        if (char_cnt == word_length - 1)
-        {
-            word_length = word_length + STANDARD_WORD_SIZE;
-            temp = (char *)realloc(word, word_length * sizeof(char));
+    return word;
+}
 
-            if (temp == NULL)
-            {
+/*
+ * Function: get_word_span
+ * -----------------------------------
+ * Description:
+ *   Skips white characters and returns the next word as a span inside the line buffer
+ *   itself: a pointer to its first character and its length, with no copy and no
+ *   allocation. The span is only valid while the line buffer is; a name that must
+ *   outlive the line is copied by the caller (interning, macro names).
+ * Parameters:
+ *   - line: The string from which the words will be extracted, advanced past the word.
+ *   - length: Output parameter receiving the length of the word.
+ * Returns:
+ *   - A pointer to the first character of the word inside the line, or NULL at the end
+ *     of the string.
+ */
 
-                free(word);
-                return NULL;
-            }
-            word = temp;
-        }
+char *get_word_span(char **line, int *length)
+{
+    char *span;
+
+    /*Skip leading whitespace*/
+    *line = skip_separators(*line);
 
-        word[char_cnt] = **line;
-        char_cnt++;
-        (*line)++;
+    /*Check for the end of the line*/
+    if (**line == '\0')
+    {
+        *length = 0;
+        return NULL; /*No more words*/
     }
 
-    /*Null-terminate the word*/
-    word[char_cnt] = '\0';
+    span = *line;
+    *line = find_word_end(span);
+    *length = *line - span;
 
-    return word;
+    return span;
+}
+
+/*
+ * Function: span_equals
+ * -----------------------------------
+ * Description:
+ *   Compares a word span against a null-terminated word, length-aware, so classifiers
+ *   can test keywords without terminating or copying the span.
+ * Parameters:
+ *   - span: The first character of the word inside the line.
+ *   - length: The length of the word.
+ *   - text: The null-terminated word to compare against.
+ * Returns:
+ *   - 1 when the span spells exactly the given word, 0 otherwise.
+ */
+
+int span_equals(char *span, int length, char *text)
+{
+    return (strncmp(span, text, length) == 0 && text[length] == '\0');
 }
 
 /**
@@ -280,20 +874,41 @@ char *get_word(char **line)
  * Returns:
  *   - The index of the directive if found, or -1 otherwise.
  * Algorithm:
- *   - Compare the provided word with predefined assembly directives.
- *   - Return the index of the directive if found, or -1 otherwise.
+ *   - Dispatch on the characters after the dot, which distinguish the four directives,
+ *     then confirm the candidate with a single strcmp instead of scanning all of them.
  */
 
 int is_directive(char *word)
 {
+    static char *directives[4] = {".data", ".string", ".entry", ".extern"};
     int i;
-    char *directives[4] = {".data", ".string", ".entry", ".extern"};
-    for (i = 0; i < 4; i++)
+
+    if (word[0] != '.')
     {
-        if (strcmp(word, directives[i]) == 0)
-        {
-            return i;
-        }
+        return -1;
+    }
+
+    switch (word[1])
+    {
+    case 'd':
+        i = 0;
+        break;
+
+    case 's':
+        i = 1;
+        break;
+
+    case 'e':
+        i = (word[2] == 'n') ? 2 : 3;
+        break;
+
+    default:
+        return -1;
+    }
+
+    if (strcmp(word, directives[i]) == 0)
+    {
+        return i;
     }
 
     return -1;
@@ -309,20 +924,31 @@ int is_directive(char *word)
  * Returns:
  *   - The index of the operation if found, or -1 otherwise.
  * Algorithm:
- *   - Compare the provided word with predefined assembly operations.
- *   - Return the index of the operation if found, or -1 otherwise.
+ *   - All mnemonics are three characters long, so words of any other length are rejected
+ *     without any comparison.
+ *   - Look up the candidate in a perfect hash table over the three characters
+ *     ((c0 * 6 + c1 * 4 + c2) mod 31 maps the 16 mnemonics to 16 distinct keys), then
+ *     confirm it with a single strcmp instead of scanning all of them.
  * */
 
 int is_operation(char *word)
 {
-    int i;
-    char *operations[16] = {"mov", "cmp", "add", "sub", "not", "clr", "lea", "inc", "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "hlt"};
-    for (i = 0; i < 16; i++)
+    static char *operations[16] = {"mov", "cmp", "add", "sub", "not", "clr", "lea", "inc", "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "hlt"};
+    static int op_dispatch[31] = {-1, 13, 6, -1, -1, -1, 9, 0, -1, -1, 11, 4, -1, 10, -1, -1, 3, -1, 8, -1, -1, -1, 7, 14, 5, 15, 1, -1, 2, 12, -1};
+    int candidate;
+
+    if (word[0] == '\0' || word[1] == '\0' || word[2] == '\0' || word[3] != '\0')
     {
-        if (strcmp(word, operations[i]) == 0)
-        {
-            return i;
-        }
+        return -1;
+    }
+
+    /*The bytes are hashed as unsigned: with a signed char, a byte above 0x7F would
+      make the sum negative and index before the table*/
+    candidate = op_dispatch[((unsigned char)word[0] * 6 + (unsigned char)word[1] * 4 + (unsigned char)word[2]) % 31];
+
+    if ((candidate != -1) && (strcmp(word, operations[candidate]) == 0))
+    {
+        return candidate;
     }
 
     return -1;
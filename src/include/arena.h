@@ -0,0 +1,100 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#define ARENA_BLOCK_SIZE 16384 /*Default size of an arena block, allocations larger than this get a dedicated block*/
+
+typedef struct ARENA ARENA;
+typedef struct ARENA_BLOCK ARENA_BLOCK;
+
+/*
+ * A bump allocator that serves the many small allocations made while assembling one
+ * file (tokens, symbol table nodes, macro bodies and so on). Memory is carved out of
+ * large blocks with simple pointer arithmetic and the whole arena is released in one
+ * shot at the end of the file, instead of freeing every node individually.
+ */
+
+struct ARENA_BLOCK
+{
+    struct ARENA_BLOCK *next;
+    long used;     /*Number of bytes already handed out from this block*/
+    long capacity; /*Total number of usable bytes in this block*/
+};
+
+struct ARENA
+{
+    ARENA_BLOCK *blocks; /*The block currently being carved is at the head of the list*/
+};
+
+/*
+ * Function: arena_init
+ * ---------------------
+ * Description:
+ *   Initializes an empty arena.
+ * Parameters:
+ *   - arena: The arena to initialize.
+ */
+
+void arena_init(ARENA *arena);
+
+/*
+ * Function: arena_alloc
+ * ----------------------
+ * Description:
+ *   Allocates size bytes from the arena.
+ * Parameters:
+ *   - arena: The arena to allocate from.
+ *   - size: The number of bytes to allocate.
+ * Returns:
+ *   - A pointer to the allocated memory, or NULL if memory allocation fails.
+ */
+
+void *arena_alloc(ARENA *arena, long size);
+
+/*
+ * Function: arena_release
+ * ------------------------
+ * Description:
+ *   Frees every block of the arena in one sweep and leaves it empty.
+ * Parameters:
+ *   - arena: The arena to release.
+ */
+
+void arena_release(ARENA *arena);
+
+/*
+ * Function: arena_set_current
+ * ----------------------------
+ * Description:
+ *   Installs the arena that allocation helpers of the calling thread draw from.
+ *   Each worker thread installs its own per-file arena, so the helpers need no
+ *   extra parameter threading through the parsing call chains.
+ * Parameters:
+ *   - arena: The arena to install, or NULL to uninstall.
+ */
+
+void arena_set_current(ARENA *arena);
+
+/*
+ * Function: arena_get_current
+ * ----------------------------
+ * Description:
+ *   Returns the arena installed for the calling thread, or NULL if none is installed.
+ */
+
+ARENA *arena_get_current(void);
+
+/*
+ * Function: arena_alloc_current
+ * ------------------------------
+ * Description:
+ *   Allocates from the arena installed for the calling thread, falling back to plain
+ *   malloc when no arena is installed (standalone tools).
+ * Parameters:
+ *   - size: The number of bytes to allocate.
+ * Returns:
+ *   - A pointer to the allocated memory, or NULL if memory allocation fails.
+ */
+
+void *arena_alloc_current(long size);
+
+#endif
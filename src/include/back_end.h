@@ -27,6 +27,25 @@
 
 int create_object_file(TRANSLATION_UNIT *curr_program, char *file_name);
 
+/*
+ * Function: create_binary_object_file
+ * -----------------------------------
+ * Description:
+ *   Creates the object file in the binary format selected with --obj-format=binary: a
+ *   versioned little-endian image with a header holding ic and dc, one 16-bit word per
+ *   memory word, and the entries and externals tables, built in memory and flushed with
+ *   a single write.
+ *
+ * Parameters:
+ *   - curr_program: Pointer to the central processing unit that contains all the relevant information about the current program.
+ *   - file_name: The file name without the .ob extension.
+ *
+ * Returns:
+ *   - MEMORY_ALLOCATION_ERROR if memory allocation or file opening failed, otherwise returns NO_ERRORS.
+ */
+
+int create_binary_object_file(TRANSLATION_UNIT *curr_program, char *file_name);
+
 /*
  * Function: create_entries_file
  * ------------------------------
@@ -0,0 +1,61 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#define CACHE_KEY_LEN 17      /*16 hex characters and the terminating null*/
+#define CACHE_COPY_BUFFER 4096 /*Size of the block used when copying cached files*/
+
+/*
+ * Function: cache_init
+ * -----------------------------------
+ * Description:
+ *   Creates the cache directory if it does not exist yet.
+ * Parameters:
+ *   - cache_dir: Path of the cache directory given with --cache-dir.
+ */
+
+void cache_init(char *cache_dir);
+
+/*
+ * Function: cache_key
+ * -----------------------------------
+ * Description:
+ *   Computes the content key of an expanded source buffer and writes it as 16 hex
+ *   characters into key_out.
+ * Parameters:
+ *   - am_buffer: The macro-expanded source of the file.
+ *   - key_out: Output buffer of at least CACHE_KEY_LEN characters.
+ */
+
+void cache_key(char *am_buffer, char *key_out);
+
+/*
+ * Function: cache_restore
+ * -----------------------------------
+ * Description:
+ *   Copies the cached .ob/.ent/.ext outputs stored under the given key to the output
+ *   files of the named source, when a cache entry for the key exists.
+ * Parameters:
+ *   - cache_dir: Path of the cache directory.
+ *   - key: The content key of the expanded source.
+ *   - file_name: The name of the input file, without the .as extension.
+ * Returns:
+ *   - 1 when the outputs were restored from the cache, 0 when there is no usable entry.
+ */
+
+int cache_restore(char *cache_dir, char *key, char *file_name);
+
+/*
+ * Function: cache_store
+ * -----------------------------------
+ * Description:
+ *   Copies the .ob/.ent/.ext outputs that were just emitted for the named source into
+ *   the cache directory under the given key.
+ * Parameters:
+ *   - cache_dir: Path of the cache directory.
+ *   - key: The content key of the expanded source.
+ *   - file_name: The name of the input file, without the .as extension.
+ */
+
+void cache_store(char *cache_dir, char *key, char *file_name);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef DIAG_H
+#define DIAG_H
+
+#define DIAG_INITIAL_CAPACITY 4096 /*Initial size of the diagnostics buffer of a file, doubled as needed*/
+
+typedef struct DIAG DIAG;
+
+/*
+ * The diagnostics sink of one file. Error lines are accumulated into the buffer and
+ * flushed with a single write at the end of the file, instead of one console write per
+ * error; with --quiet-after=N the sink stops keeping lines after N errors and the
+ * passes stop parsing, so a badly broken file fails as fast as a clean one assembles.
+ */
+
+struct DIAG
+{
+    char *buffer;
+    int length;
+    int capacity;
+    int reported;   /*Number of error lines kept in the buffer*/
+    int suppressed; /*Number of error lines dropped after the limit was reached*/
+    int limit;      /*Stop keeping lines after this many errors, 0 when unlimited*/
+};
+
+/*The value of the --quiet-after=N option, 0 when it was not given*/
+extern int diag_quiet_after;
+
+/*
+ * Function: diag_open
+ * --------------------
+ * Description:
+ *   Initializes the sink with the configured limit and installs it as the sink of the
+ *   calling thread, so diag_error needs no parameter threading through the passes.
+ *
+ * Parameters:
+ *   - diag: The sink to open.
+ */
+
+void diag_open(DIAG *diag);
+
+/*
+ * Function: diag_error
+ * ---------------------
+ * Description:
+ *   Formats one diagnostic line into the sink of the calling thread, with the printf
+ *   formatting the error sites already use. Without an installed sink the line is
+ *   printed directly, so callers outside the per-file flow need nothing special.
+ *
+ * Parameters:
+ *   - format: The printf format of the line, followed by its arguments.
+ */
+
+void diag_error(char *format, ...);
+
+/*
+ * Function: diag_limit_reached
+ * -----------------------------
+ * Description:
+ *   Tells whether the sink of the calling thread has reached its error limit, so the
+ *   per-line loops of the passes can stop parsing instead of producing more errors.
+ *
+ * Returns:
+ *   - 1 when the limit was reached, 0 otherwise (including when there is no sink or limit).
+ */
+
+int diag_limit_reached(void);
+
+/*
+ * Function: diag_flush
+ * ---------------------
+ * Description:
+ *   Prints the accumulated diagnostics of the sink with a single write, notes how many
+ *   lines were dropped when the limit was reached, releases the buffer and uninstalls
+ *   the sink from the calling thread.
+ *
+ * Parameters:
+ *   - diag: The sink to flush.
+ */
+
+void diag_flush(DIAG *diag);
+
+#endif
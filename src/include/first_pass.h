@@ -8,6 +8,58 @@
 #include "general.h"
 #include "pre_assembler.h"
 
+#define AST_STREAM_INITIAL_CAPACITY 64 /*Initial number of nodes in an AST stream, doubled as needed*/
+
+typedef struct AST_NODE AST_NODE;
+typedef struct AST_STREAM AST_STREAM;
+
+/*A parsed line together with the number of the line it came from in the am source*/
+struct AST_NODE
+{
+    LINE_AST ast;
+    int line_num;
+    int cells; /*Memory cells of the line when computed by the pipelined consumer, -1 otherwise*/
+};
+
+/*A growable array of the ASTs that the first pass parsed, reused by the second pass
+  so the front end does not run over the whole file a second time*/
+struct AST_STREAM
+{
+    AST_NODE *nodes;
+    int count;
+    int capacity;
+};
+
+/*
+ * Function: ast_stream_append
+ * ----------------------------
+ * Description:
+ *   Appends a parsed line to the AST stream, growing the stream if needed.
+ *
+ * Parameters:
+ *   ast_stream: The stream to append to.
+ *   ast: The parsed line to store.
+ *   line_num: The number of the line in the am source.
+ *   cells: The number of memory cells the line occupies, or -1 when not computed yet.
+ *
+ * Returns:
+ *   NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int ast_stream_append(AST_STREAM *ast_stream, LINE_AST *ast, int line_num, int cells);
+
+/*
+ * Function: free_ast_stream
+ * --------------------------
+ * Description:
+ *   Frees the memory allocated for the nodes of an AST stream.
+ *
+ * Parameters:
+ *   ast_stream: The stream whose nodes should be freed.
+ */
+
+void free_ast_stream(AST_STREAM *ast_stream);
+
 /* 
  * Function: insert_symbol
  * -----------------------
@@ -25,7 +77,7 @@
  *   An integer representing the success or failure of the operation.
  */
 
-int insert_symbol(SYMBOL *symbol_table[HASH_TABLE_SIZE], char *symbol_name, int symbol_type, int address, int value);
+int insert_symbol(HASH_TABLE *symbol_table, char *symbol_name, int symbol_type, int address, int value);
 
 /* 
  * Function: memory_cell_calculator
@@ -53,14 +105,58 @@ int memory_cell_calculator(LINE_AST line);
  *
  * Parameters:
  *   curr_program: Pointer to the current translation unit being processed.
- *   am_file: Pointer to the assembly file.
- *   am_file_name: Name of the assembly file.
- *   macro_table: An array of pointers to MACRO structures representing macro definitions.
+ *   am_buffer: The in-memory macro-expanded source produced by pre_assembly.
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   ast_stream: The stream that is filled with the parsed lines, for reuse by the second pass.
  *
  * Returns:
  *   An integer representing the success or failure of the operation.
  */
 
-int first_pass(TRANSLATION_UNIT *curr_program, FILE *am_file, char *am_file_name, MACRO *macro_table[HASH_TABLE_SIZE]);
+int first_pass(TRANSLATION_UNIT *curr_program, char *am_buffer, char *am_file_name, HASH_TABLE *macro_table, AST_STREAM *ast_stream);
+
+/*
+ * Function: first_pass_from_stream
+ * ---------------------------------
+ * Description:
+ *   Performs the first pass over an AST stream that was already parsed by the pipelined
+ *   consumer (see pipelined_pre_assembly), doing only the symbol table work.
+ *
+ * Parameters:
+ *   curr_program: Pointer to the current translation unit being processed.
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   ast_stream: The stream of lines parsed by the pipelined consumer, in source order.
+ *
+ * Returns:
+ *   NO_ERRORS if successful, SYNTAX_OR_LOGIC_ERROR if a syntax or logic error was
+ *   encountered and MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int first_pass_from_stream(TRANSLATION_UNIT *curr_program, char *am_file_name, HASH_TABLE *macro_table, AST_STREAM *ast_stream);
+
+/*
+ * Function: single_pass
+ * ----------------------
+ * Description:
+ *   Performs the whole assembly of a file in a single traversal of the expanded source
+ *   (the --single-pass mode): each line is parsed once, the symbol table work runs on it
+ *   and it is encoded immediately, with unresolved label and constant operands recorded
+ *   as fixups that are patched from the completed symbol table after the last line. The
+ *   caller must not run second_pass afterwards.
+ *
+ * Parameters:
+ *   curr_program: Pointer to the current translation unit being processed.
+ *   am_buffer: The in-memory macro-expanded source produced by pre_assembly.
+ *   am_file_name: Name of the assembly file (used in error messages).
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *
+ * Returns:
+ *   NO_ERRORS if the operation is successful, SYNTAX_OR_LOGIC_ERROR if a syntax or logic
+ *   error was encountered and MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int single_pass(TRANSLATION_UNIT *curr_program, char *am_buffer, char *am_file_name, HASH_TABLE *macro_table);
 #endif
 
@@ -3,7 +3,6 @@
 
 #include "general.h"
 
-#define MAX_ERR_DETAIL_LEN 175 /*Details about the error type will be a maximum of 100 characters*/
 #define MAX_INST_OPERANDS 2
 #define NON_VALID_NUM 3000 /*3000 cannot be represented in the 2's complement method by 12 bits*/
 #define MAX_DATA_OPERANDS 50
@@ -28,8 +27,8 @@ struct INST_OPERAND
     } type;
 
     int num;
-    char label[MAX_LABEL_LEN];
-    char constant_name[MAX_LABEL_LEN];
+    char *label;         /*Interned, compared by pointer in the passes*/
+    char *constant_name; /*Interned, NULL when the operand has no constant index*/
 };
 
 struct DATA
@@ -43,7 +42,7 @@ struct DATA
     union
     {
         int num;
-        char constant_name[MAX_LABEL_LEN];
+        char *constant_name; /*Interned*/
     } data_value;
 };
 
@@ -61,9 +60,9 @@ struct DIRECTIVE
 
     union operands
     {
-        DATA data[MAX_DATA_OPERANDS];      /* for data directive */
-        int str[MAX_LABEL_LEN];            /* store the asci code of the strings chars */
-        char label_operand[MAX_LABEL_LEN]; /* Store the label name of the extern/entry */
+        DATA *data;          /* arena array of up to MAX_DATA_OPERANDS entries, for the data directive */
+        int *str;            /* arena array holding the ascii codes of the string, zero terminated */
+        char *label_operand; /* Interned label name of the extern/entry */
 
     } operands;
 };
@@ -95,14 +94,14 @@ struct INSTRUCTION
 
 struct CONSTANT_DEFINITION
 {
-    char constant_name[MAX_LABEL_LEN];
+    char *constant_name; /*Interned*/
     int constant_num;
 };
 
 struct LINE_AST
 {
-    char error_detail[MAX_ERR_DETAIL_LEN + 1];
-    char label[MAX_LABEL_LEN + 1];
+    char *error_detail; /*Points at the constant description of the error, NULL when there is none*/
+    char *label;        /*Interned label defined by the line, NULL when the line has none*/
 
     enum
     {
@@ -289,6 +288,20 @@ int check_constant_def_operand(char **line, LINE_AST *ast);
 
 int check_operand(char **line, LINE_AST *ast);
 
+/*
+ * Function: parse_line_into
+ * --------------------------
+ * Description:
+ *   Parses a line of assembly code into the given LINE_AST slot, so callers reuse one
+ *   slot per loop instead of copying the structure out of the parser for every line.
+ *
+ * Parameters:
+ *   ast: The slot receiving the parsed line.
+ *   line: The line of assembly code.
+ */
+
+void parse_line_into(LINE_AST *ast, char *line);
+
 /*
  * Function: create_ast_from_text
  * ------------------------------
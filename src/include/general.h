@@ -4,8 +4,10 @@
 #define STANDARD_WORD_SIZE 5
 #define MAX_LINE_LEN 82
 #define MAX_LABEL_LEN 32        /*31 places for the maximum length of a label and one more for '\0' */
-#define HASH_TABLE_SIZE 19      /*Prime number to reduce collisions in the hash function*/
-#define MAX_PROGRAM_LENGTH 3996 /*The maximum program length is 4096, but the first 100 memory cells are unused*/
+#define HASH_TABLE_INITIAL_CAPACITY 32 /*Power of two, the slot index is taken with a bit mask*/
+#define MEMORY_IMAGE_INITIAL_CAPACITY 256 /*Initial number of words in a memory image, doubled as needed*/
+#define EXT_REFS_INITIAL_CAPACITY 16      /*Initial size of the external reference vector, doubled as needed*/
+#define ENTRIES_INITIAL_CAPACITY 8        /*Initial size of the entry symbol vector, doubled as needed*/
 #define DESTINATION_OPERAND 1
 #define SOURCE_OPERAND 0
 #define MEMORY_ALLOCATION_ERROR -2
@@ -16,15 +18,53 @@ typedef struct TRANSLATION_UNIT TRANSLATION_UNIT;
 
 typedef struct SYMBOL SYMBOL;
 
-typedef struct EXT_SYMBOL EXT_SYMBOL;
+typedef struct EXT_REF EXT_REF;
 
-typedef struct EXT_ADDRESS EXT_ADDRESS;
+typedef struct MEMORY_IMAGE MEMORY_IMAGE;
 
-typedef struct ENTRY_NODE ENTRY_NODE;
+typedef struct HASH_SLOT HASH_SLOT;
+
+typedef struct HASH_TABLE HASH_TABLE;
+
+/*A growable image of encoded memory words, bit-packed at 14 bits per word (seven bytes
+  hold four words) since that is the full ISA word. The words are only touched through
+  memory_image_or and memory_image_get, which OR bits into a word and read it back; all
+  words are zero until encoded into. Small files stay within the small initial
+  allocation and large generated programs are no longer capped by a fixed array size.*/
+struct MEMORY_IMAGE
+{
+    unsigned char *bytes;
+    int capacity; /*Number of allocated words (not bytes)*/
+};
+
+/*One slot of an open-addressing hash table. A slot is empty while its name is NULL.
+  The full hash is stored next to the name, so probing compares two integers and only
+  falls back to strcmp when the hashes match.*/
+struct HASH_SLOT
+{
+    unsigned int hash;
+    char *name;
+    void *node;
+};
+
+/*A growable open-addressing hash table with linear probing. The capacity is always a
+  power of two and the table is rehashed into a table twice as large when it becomes
+  three quarters full, so probe sequences stay short no matter how many names a
+  generated source defines. The same table serves the symbol table and the macro table.*/
+struct HASH_TABLE
+{
+    HASH_SLOT *slots;
+    int capacity;
+    int count;
+    long lookups; /*Number of lookups, only counted in --profile mode*/
+    long probes;  /*Number of slots examined by lookups, only counted in --profile mode*/
+    int shared;   /*When different from 0 the table is read by several threads at once,
+                    so the unsynchronized profile counters above are not bumped*/
+};
 
 struct SYMBOL
 {
-    char name[MAX_LABEL_LEN];
+    char *name; /*Interned, so the table can compare names by pointer*/
 
     enum
     {
@@ -39,77 +79,123 @@ struct SYMBOL
 
     int address;
     int value; /*in case of constant*/
-
-    struct SYMBOL *next;
-};
-
-struct EXT_SYMBOL
-{
-    char ext_name[MAX_LABEL_LEN];
-    EXT_ADDRESS *address; /*A pointer to a linked list containing all the addresses that the label is in*/
-    struct EXT_SYMBOL *next_ext;
-};
-
-struct EXT_ADDRESS
-{
-    int num;
-    struct EXT_ADDRESS *next_address;
 };
 
-struct ENTRY_NODE
+/*One reference to an external symbol. The references are appended while the machine
+  code is encoded, so the vector is sorted by address by construction and the externals
+  file is emitted with a single sweep over it.*/
+struct EXT_REF
 {
-    SYMBOL *symbol;
-    struct ENTRY_NODE *next;
+    char *ext_name; /*Interned name, shared with the symbol table*/
+    int address;    /*Address of the reference in the machine code*/
 };
 
 struct TRANSLATION_UNIT
 {
-    short instruction_array[MAX_PROGRAM_LENGTH];
-    short data_array[MAX_PROGRAM_LENGTH];
+    MEMORY_IMAGE instruction_image;
+    MEMORY_IMAGE data_image;
     int ic;
     int dc;
-    SYMBOL *symbol_table[HASH_TABLE_SIZE];
-    EXT_SYMBOL *ext_list;
-    int external_counter;
-    ENTRY_NODE *entries_list;
-    int entries_counter;
+    HASH_TABLE symbol_table;
+    EXT_REF *ext_refs;        /*A contiguous vector of the external references, in address order*/
+    int external_counter;     /*Number of recorded external references*/
+    int ext_refs_capacity;    /*Allocated capacity of the reference vector*/
+    SYMBOL **entries;         /*A contiguous vector of the entry symbols, sorted by address*/
+    int entries_counter;      /*Number of entry symbols*/
+    int entries_capacity;     /*Allocated capacity of the entry vector*/
 };
 
 /*
- * Function: free_ext_list
+ * Function: free_ext_refs
  * -----------------------------------
  * Description:
- *   Frees the memory allocated for the linked list of external symbols.
+ *   Releases the vector of external references of a translation unit.
  * Parameters:
- *   - head: Pointer to the head of the linked list of external symbols.
+ *   - curr_program: The translation unit whose reference vector should be freed.
  * Returns: None
  */
 
-void free_ext_list(EXT_SYMBOL **head);
+void free_ext_refs(TRANSLATION_UNIT *curr_program);
 
 /*
- * Function: free_entries_list
+ * Function: free_entries
  * -----------------------------------
  * Description:
- *   Frees the memory allocated for a linked list of entry symbol pointers.
+ *   Releases the vector of entry symbol pointers of a translation unit (the symbols are
+ *   owned by the per-file arena).
  * Parameters:
- *   - head: A pointer to the head of the linked list of entry nodes.
+ *   - curr_program: The translation unit whose entry vector should be freed.
  * Returns: None
  */
 
-void free_entries_list(ENTRY_NODE *head);
+void free_entries(TRANSLATION_UNIT *curr_program);
 
 /*
  * Function: free_symbol_table
  * -----------------------------------
  * Description:
- *   Frees the symbol table and initializes it to NULL.
+ *   Resets the symbol table to empty (the symbol nodes are owned by the per-file arena).
  * Parameters:
  *   - symbol_table: The symbol table for which the allocated memory should be freed.
  * Returns: None
  */
 
-void free_symbol_table(SYMBOL **symbol_table);
+void free_symbol_table(HASH_TABLE *symbol_table);
+
+/*
+ * Function: memory_image_reserve
+ * -----------------------------------
+ * Description:
+ *   Makes sure a memory image has at least the requested number of words, growing it
+ *   with zero-filled words when needed (the encoding uses |= and relies on zeros).
+ * Parameters:
+ *   - image: The memory image to grow.
+ *   - needed_capacity: The number of words the caller is about to address.
+ * Returns:
+ *   - NO_ERRORS if the room is available, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int memory_image_reserve(MEMORY_IMAGE *image, int needed_capacity);
+
+/*
+ * Function: memory_image_or
+ * -----------------------------------
+ * Description:
+ *   ORs the low 14 bits of a value into the word at the given index of a bit-packed
+ *   memory image. The index must be below the reserved capacity.
+ * Parameters:
+ *   - image: The memory image to encode into.
+ *   - index: The index of the word.
+ *   - value: The bits to OR into the word (only the low 14 bits are kept).
+ * Returns: None
+ */
+
+void memory_image_or(MEMORY_IMAGE *image, int index, int value);
+
+/*
+ * Function: memory_image_get
+ * -----------------------------------
+ * Description:
+ *   Reads the 14-bit word at the given index of a bit-packed memory image.
+ * Parameters:
+ *   - image: The memory image to read from.
+ *   - index: The index of the word.
+ * Returns:
+ *   - The word, as a non-negative value below 1 << 14.
+ */
+
+int memory_image_get(MEMORY_IMAGE *image, int index);
+
+/*
+ * Function: free_memory_image
+ * -----------------------------------
+ * Description:
+ *   Frees the words of a memory image and resets it to empty.
+ * Parameters:
+ *   - image: The memory image to free.
+ */
+
+void free_memory_image(MEMORY_IMAGE *image);
 
 /*
  * Function: dynamic_strcat
@@ -125,28 +211,126 @@ void free_symbol_table(SYMBOL **symbol_table);
 
 char *dynamic_strcat(char *first_string, char *second_string);
 
+/*
+ * Function: buffer_gets
+ * -----------------------------------
+ * Description:
+ *   Reads the next line from an in-memory source buffer, mirroring the behavior of fgets.
+ * Parameters:
+ *   - dest: The destination array into which the line is copied.
+ *   - max_len: The size of the destination array.
+ *   - cursor: Pointer to the current reading position inside the buffer, advanced past the line that was read.
+ * Returns:
+ *   - dest if a line was read, or NULL if the end of the buffer was reached.
+ */
+
+char *buffer_gets(char *dest, int max_len, char **cursor);
+
 /*
  * Function: symbol_lookup
  * -----------------------------------
  * Description:
- *   Looks up a node in a hash table based on the provided name.
+ *   Looks up a symbol in the symbol table based on the provided name.
  * Parameters:
- *   - name: The name to be looked up in the hash table.
- *   - hash_table: An array of pointers to nodes representing the hash table.
+ *   - name: The name to be looked up in the symbol table.
+ *   - symbol_table: The open-addressing symbol table.
+ * Returns:
+ *   - A pointer to the found symbol if it exists, or NULL if the symbol is not found.
+ */
+SYMBOL *symbol_lookup(char *name, HASH_TABLE *symbol_table);
+
+/*
+ * Function: hash_table_lookup
+ * -----------------------------------
+ * Description:
+ *   Looks up a node in an open-addressing hash table based on the provided name.
+ * Parameters:
+ *   - table: The hash table to search.
+ *   - name: The name to be looked up.
  * Returns:
  *   - A pointer to the found node if it exists, or NULL if the node is not found.
  */
-SYMBOL *symbol_lookup(char *name, SYMBOL *hash_table[HASH_TABLE_SIZE]); /*need to change to generic*/
+
+void *hash_table_lookup(HASH_TABLE *table, char *name);
+
+/*
+ * Function: hash_table_lookup_interned
+ * -----------------------------------
+ * Description:
+ *   Looks up a node in an open-addressing hash table whose names are all interned,
+ *   so equal names are the same pointer and probes compare pointers instead of strcmp.
+ * Parameters:
+ *   - table: The hash table to search.
+ *   - name: The interned name to be looked up.
+ * Returns:
+ *   - A pointer to the found node if it exists, or NULL if the node is not found.
+ */
+
+void *hash_table_lookup_interned(HASH_TABLE *table, char *name);
+
+/*
+ * Function: intern_set_current
+ * -----------------------------------
+ * Description:
+ *   Installs the interning pool of the file the calling thread is processing. Passing
+ *   NULL removes the pool.
+ * Parameters:
+ *   - pool: The hash table holding the interned names of the file.
+ */
+
+void intern_set_current(HASH_TABLE *pool);
+
+/*
+ * Function: intern_name
+ * -----------------------------------
+ * Description:
+ *   Returns the single canonical copy of the given name from the interning pool of the
+ *   calling thread, copying it into the per-file arena on the first occurrence. Equal
+ *   names always return the same pointer, so they can be compared by pointer.
+ * Parameters:
+ *   - name: The name to intern.
+ * Returns:
+ *   - The canonical copy of the name, or NULL if memory allocation fails.
+ */
+
+char *intern_name(char *name);
+
+/*
+ * Function: hash_table_insert
+ * -----------------------------------
+ * Description:
+ *   Inserts a node under the provided name into an open-addressing hash table,
+ *   growing and rehashing the table when it becomes three quarters full.
+ * Parameters:
+ *   - table: The hash table to insert into.
+ *   - name: The name under which the node is stored (not copied, must outlive the table).
+ *   - node: The node to store.
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int hash_table_insert(HASH_TABLE *table, char *name, void *node);
+
+/*
+ * Function: free_hash_table
+ * -----------------------------------
+ * Description:
+ *   Frees the slot array of an open-addressing hash table and resets it to empty.
+ * Parameters:
+ *   - table: The hash table to free.
+ */
+
+void free_hash_table(HASH_TABLE *table);
 
 /*
  * Function: hash
  * -----------------------------------
  * Description:
- *   Allocates for a name, index in the hash table.
+ *   Calculates the hash value of a name.
  * Parameters:
  *   - name: The name for which to calculate the hash value.
  * Returns:
- *   - The index in the hash table.
+ *   - The full hash value (the table index is derived from it with a bit mask).
  */
 
 unsigned int hash(char *word);
@@ -160,10 +344,45 @@ unsigned int hash(char *word);
  *   - line: The string from which the words will be extracted.
  * Returns:
  *   - The next word in the string, or NULL in case of end of string or memory allocation error.
+ *     The word is allocated from the per-file arena and must not be freed by the caller.
  */
 
 char *get_word(char **line);
 
+/*
+ * Function: get_word_span
+ * -----------------------------------
+ * Description:
+ *   Skips white characters and returns the next word as a span inside the line buffer
+ *   itself: a pointer to its first character and its length, with no copy and no
+ *   allocation. The span is only valid while the line buffer is; a name that must
+ *   outlive the line is copied by the caller (interning, macro names).
+ * Parameters:
+ *   - line: The string from which the words will be extracted, advanced past the word.
+ *   - length: Output parameter receiving the length of the word.
+ * Returns:
+ *   - A pointer to the first character of the word inside the line, or NULL at the end
+ *     of the string.
+ */
+
+char *get_word_span(char **line, int *length);
+
+/*
+ * Function: span_equals
+ * -----------------------------------
+ * Description:
+ *   Compares a word span against a null-terminated word, length-aware, so classifiers
+ *   can test keywords without terminating or copying the span.
+ * Parameters:
+ *   - span: The first character of the word inside the line.
+ *   - length: The length of the word.
+ *   - text: The null-terminated word to compare against.
+ * Returns:
+ *   - 1 when the span spells exactly the given word, 0 otherwise.
+ */
+
+int span_equals(char *span, int length, char *text);
+
 /*
  * Function: is_directive
  * -----------------------------------
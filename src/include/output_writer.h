@@ -0,0 +1,88 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#define OUTPUT_WRITER_INITIAL_CAPACITY 8192 /*Initial size of the output buffer, doubled as needed*/
+
+typedef struct OUTPUT_WRITER OUTPUT_WRITER;
+
+/*
+ * A writer that builds the whole content of an output file in one in-memory buffer and
+ * flushes it with a single write, instead of issuing a formatted write per memory word.
+ * Allocation failures are sticky: after a failed growth the put functions do nothing and
+ * the failure is reported once by output_writer_flush, so the encoding loops do not need
+ * to check every append.
+ */
+
+struct OUTPUT_WRITER
+{
+    char *buffer;
+    int length;
+    int capacity;
+    int error_flag; /*Set when a growth of the buffer failed, checked by output_writer_flush*/
+};
+
+/*
+ * Function: output_writer_init
+ * -----------------------------
+ * Description:
+ *   Initializes the writer and allocates its initial buffer.
+ * Parameters:
+ *   - writer: The writer to initialize.
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int output_writer_init(OUTPUT_WRITER *writer);
+
+/*
+ * Function: output_writer_put_char
+ * ---------------------------------
+ * Description:
+ *   Appends one character to the output buffer.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - c: The character to append.
+ */
+
+void output_writer_put_char(OUTPUT_WRITER *writer, char c);
+
+/*
+ * Function: output_writer_put_string
+ * -----------------------------------
+ * Description:
+ *   Appends a null-terminated string to the output buffer.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - text: The string to append.
+ */
+
+void output_writer_put_string(OUTPUT_WRITER *writer, char *text);
+
+/*
+ * Function: output_writer_put_number
+ * -----------------------------------
+ * Description:
+ *   Appends the decimal digits of a number to the output buffer, without printf formatting.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - number: The number to append.
+ */
+
+void output_writer_put_number(OUTPUT_WRITER *writer, int number);
+
+/*
+ * Function: output_writer_flush
+ * ------------------------------
+ * Description:
+ *   Writes the whole buffer to the named file with a single write and releases the buffer.
+ * Parameters:
+ *   - writer: The writer to flush.
+ *   - out_file_name: The name of the output file.
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if an append failed earlier or the
+ *     file cannot be opened.
+ */
+
+int output_writer_flush(OUTPUT_WRITER *writer, char *out_file_name);
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <pthread.h>
+
+#include "general.h"
+#include "arena.h"
+
+#define PIPELINE_RING_CAPACITY 256 /*Number of expanded lines the ring buffers between the threads*/
+
+typedef struct PIPELINE_RING PIPELINE_RING;
+
+/*A bounded ring of expanded source lines. The pre-assembler thread pushes every line it
+  appends to the expanded source and the parsing thread pops them, so macro expansion and
+  parsing overlap instead of running one after the other. The ring blocks the producer
+  when it is full and the consumer when it is empty.*/
+struct PIPELINE_RING
+{
+    char lines[PIPELINE_RING_CAPACITY][MAX_LINE_LEN];
+    int head;  /*Index of the next line to pop*/
+    int tail;  /*Index of the next free slot*/
+    int count; /*Number of buffered lines*/
+    int done;  /*Set when the producer finished, so the consumer stops after draining*/
+    pthread_mutex_t lock;
+    pthread_cond_t not_full;
+    pthread_cond_t not_empty;
+};
+
+/*
+ * Function: pipeline_push_text
+ * -----------------------------
+ * Description:
+ *   Splits a chunk of expanded source into lines and pushes each one into the ring,
+ *   blocking while the ring is full. Called by the pre-assembler for every chunk it
+ *   appends to the expanded source.
+ * Parameters:
+ *   - ring: The ring between the pre-assembler and the parser.
+ *   - text: The chunk to push, one line or a whole macro body.
+ */
+
+void pipeline_push_text(PIPELINE_RING *ring, char *text);
+
+/*
+ * Function: pipelined_pre_assembly
+ * ---------------------------------
+ * Description:
+ *   Runs pre_assembly on a producer thread while parsing the expanded lines into the
+ *   AST stream on the calling thread, so macro expansion and parsing overlap. The
+ *   symbol table work is done afterwards by first_pass_from_stream over the parsed
+ *   stream.
+ * Parameters:
+ *   - file_name: The name of the input file, without the .as extension.
+ *   - macro_table: The hash table that receives the macro definitions.
+ *   - keep_am_flag: When different from 0, the expanded source is also written to a .am file.
+ *   - ast_stream: The stream that receives the parsed lines.
+ *   - producer_arena: The arena serving the allocations of the producer thread.
+ * Returns:
+ *   - The macro-expanded source buffer (owned by the caller), or NULL if an error occurred.
+ */
+
+struct AST_STREAM;
+char *pipelined_pre_assembly(char *file_name, HASH_TABLE *macro_table, int keep_am_flag,
+                             struct AST_STREAM *ast_stream, ARENA *producer_arena);
+
+#endif
@@ -4,9 +4,25 @@
 
 #include "general.h"
 
-typedef struct TEXT TEXT;
+#define AM_BUFFER_INITIAL_CAPACITY 1024    /*Initial size of the in-memory expanded source buffer, doubled as needed*/
+#define MACRO_CONTENT_INITIAL_CAPACITY 256 /*Initial size of the body buffer of a macro, doubled as needed*/
+
 typedef struct MACRO MACRO;
 
+typedef struct MACRO_FILTER MACRO_FILTER;
+
+/*A cheap pre-filter consulted before the macro table lookup. Well under one line in a
+  hundred invokes a macro, so the common line should not pay for a hash lookup: a word
+  can only be a macro call when the bit of its first character is set in the bitmap and
+  its length lies within the bounds of the defined macro names. An all-zero filter (no
+  macros defined yet) rejects every word.*/
+struct MACRO_FILTER
+{
+    unsigned char first_chars[32]; /*One bit per possible first character of a macro name*/
+    int min_length;                /*Length of the shortest macro name, 0 while no macro is defined*/
+    int max_length;                /*Length of the longest macro name*/
+};
+
 /*
  * Function: macro_lookup
  * -----------------------
@@ -14,13 +30,13 @@ typedef struct MACRO MACRO;
  *
  * Parameters:
  *   name: The name of the macro to lookup.
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
  *
  * Returns:
  *   A pointer to the found macro if it exists, otherwise NULL.
  */
 
-MACRO *macro_lookup(char *name, MACRO *macro_table[HASH_TABLE_SIZE]);
+MACRO *macro_lookup(char *name, HASH_TABLE *macro_table);
 
 /*
  * Function: insert_macro
@@ -29,14 +45,15 @@ MACRO *macro_lookup(char *name, MACRO *macro_table[HASH_TABLE_SIZE]);
  *
  * Parameters:
  *   macro_name: The name of the macro to insert.
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   filter: The macro call pre-filter, updated with the new name.
  *   file_name: The name of the source file.
  *
  * Returns:
  *   A pointer to the inserted macro.
  */
 
-MACRO *insert_macro(char *macro_name, MACRO *macro_table[HASH_TABLE_SIZE], char *file_name);
+MACRO *insert_macro(char *macro_name, HASH_TABLE *macro_table, MACRO_FILTER *filter, char *file_name);
 
 /*
  * Function: text_insert
@@ -63,7 +80,8 @@ int text_insert(MACRO *macro, char *line, char *file_name, int line_num);
  * Parameters:
  *   line: The line of text being processed.
  *   mcr_ptr: Pointer to the current macro (if any).
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   filter: The macro call pre-filter, consulted before the table lookup.
  *   file_name: The name of the source file.
  *   line_num: The line number being processed.
  *
@@ -71,7 +89,7 @@ int text_insert(MACRO *macro, char *line, char *file_name, int line_num);
  *   The type of line identified (e.g., macro_definition, macro_call, etc.).
  */
 
-int line_identifier(char *line, MACRO **mcr_ptr, MACRO *macro_table[HASH_TABLE_SIZE], char *file_name, int line_num);
+int line_identifier(char *line, MACRO **mcr_ptr, HASH_TABLE *macro_table, MACRO_FILTER *filter, char *file_name, int line_num);
 
 /*
  * Function: pre_assembly
@@ -80,24 +98,72 @@ int line_identifier(char *line, MACRO **mcr_ptr, MACRO *macro_table[HASH_TABLE_S
  *
  * Parameters:
  *   file_name: The name of the assembly file.
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   keep_am_flag: When different from 0, the expanded source is also written to a .am file (debug aid).
  *
  * Returns:
- *   A pointer to the name of the processed assembly file.
+ *   A pointer to a dynamically allocated buffer containing the macro-expanded source,
+ *   or NULL if an error occurred. The caller is responsible for freeing the buffer.
+ */
+
+char *pre_assembly(char *file_name, HASH_TABLE *macro_table, int keep_am_flag);
+
+/*
+ * Function: pre_assembly_streamed
+ * --------------------------------
+ * Description:
+ *   Performs preprocessing on the assembly file like pre_assembly, additionally pushing
+ *   every expanded line into the given ring so the parsing thread of the --pipeline
+ *   mode consumes the lines while they are produced.
+ * Parameters:
+ *   - file_name: The name of the assembly file.
+ *   - macro_table: The open-addressing hash table containing macro definitions.
+ *   - keep_am_flag: When different from 0, the expanded source is also written to a .am file.
+ *   - sink: The ring receiving the expanded lines.
+ * Returns:
+ *   - A pointer to a dynamically allocated buffer containing the macro-expanded source,
+ *     or NULL if an error occurred. The caller is responsible for freeing the buffer.
+ */
+
+struct PIPELINE_RING;
+char *pre_assembly_streamed(char *file_name, HASH_TABLE *macro_table, int keep_am_flag, struct PIPELINE_RING *sink);
+
+/*
+ * Function: macro_library_load
+ * -----------------------------
+ * Description:
+ *   Loads the shared macro library given with --macro-lib into a process-wide table that
+ *   macro_lookup consults after missing the per-file table. Must be called before any
+ *   file is assembled; the table is read-only afterwards. The caller must install the
+ *   arena that should own the macro nodes before calling.
+ * Parameters:
+ *   - lib_file_name: Path of the macro library file.
+ * Returns:
+ *   - NO_ERRORS if the library was loaded, SYNTAX_OR_LOGIC_ERROR if the file cannot be
+ *     opened or a definition is malformed, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int macro_library_load(char *lib_file_name);
+
+/*
+ * Function: macro_library_free
+ * -----------------------------
+ * Description:
+ *   Releases the table of the shared macro library at the end of the run.
  */
 
-char *pre_assembly(char *file_name, MACRO *macro_table[HASH_TABLE_SIZE]);
+void macro_library_free(void);
 
 /*
  * Function: free_macro_content
  * -----------------------------
- * Frees the memory allocated for a macro's content (lines of text).
+ * Frees the body buffer of a macro with a single call.
  *
  * Parameters:
- *   content: The content of the macro to free.
+ *   macro: The macro whose content should be freed.
  */
 
-void free_macro_content(TEXT *content);
+void free_macro_content(MACRO *macro);
 
 /*
  * Function: free_macro_table
@@ -105,9 +171,9 @@ void free_macro_content(TEXT *content);
  * Frees the memory allocated for the macro hash table and its contents.
  *
  * Parameters:
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
  */
 
-void free_macro_table(MACRO *macro_table[HASH_TABLE_SIZE]);
+void free_macro_table(HASH_TABLE *macro_table);
 
 #endif
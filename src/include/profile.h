@@ -0,0 +1,66 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/*Identifiers of the allocation sites counted in profile mode*/
+enum
+{
+    profile_alloc_get_word,
+    profile_alloc_dynamic_strcat,
+    profile_alloc_insert_symbol,
+    profile_alloc_counters
+};
+
+/*Set once in main when --profile is given, before any worker thread starts.
+  All the profiling hooks are disabled while it is 0.*/
+extern int profile_enabled;
+
+/*
+ * Function: profile_count_alloc
+ * ------------------------------
+ * Description:
+ *   Counts one allocation at the given site. Does nothing when profiling is disabled.
+ * Parameters:
+ *   - site: One of the profile_alloc_* identifiers.
+ */
+
+void profile_count_alloc(int site);
+
+/*
+ * Function: profile_record_file
+ * ------------------------------
+ * Description:
+ *   Prints the machine-readable per-file profile lines and accumulates the values into
+ *   the aggregate totals. Called by process_file when profiling is enabled.
+ * Parameters:
+ *   - file_name: The name of the input file, without the .as extension.
+ *   - pre_seconds, first_seconds, second_seconds, back_seconds: Wall time of each stage.
+ *   - symbol_lookups, symbol_probes: Lookup statistics of the symbol table of the file.
+ *   - macro_lookups, macro_probes: Lookup statistics of the macro table of the file.
+ */
+
+void profile_record_file(char *file_name, double pre_seconds, double first_seconds,
+                         double second_seconds, double back_seconds,
+                         long symbol_lookups, long symbol_probes,
+                         long macro_lookups, long macro_probes);
+
+/*
+ * Function: profile_report
+ * -------------------------
+ * Description:
+ *   Prints the machine-readable aggregate summary: total stage times, allocation counts,
+ *   lookup statistics and the peak memory of the process. Called once by main after all
+ *   files were processed.
+ */
+
+void profile_report(void);
+
+/*
+ * Function: profile_seconds_now
+ * ------------------------------
+ * Description:
+ *   Returns the current wall clock time in seconds, with microsecond resolution.
+ */
+
+double profile_seconds_now(void);
+
+#endif
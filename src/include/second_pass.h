@@ -9,39 +9,55 @@
 #include "pre_assembler.h"
 #include "first_pass.h"
 
-/*
- * Function: ext_search
- * ---------------------
- * Description:
- *   This function searches for a given symbol name in the external symbol list.
- *
- * Parameters:
- *   - ext_list: Pointer to the head of the external symbol list.
- *   - symbol_name: Name of the symbol to search for.
- *
- * Returns:
- *   - Pointer to the symbol if found, otherwise NULL.
- */
+#define FIXUP_LIST_INITIAL_CAPACITY 64 /*Initial size of the fixup vector of the single-pass mode, doubled as needed*/
 
-EXT_SYMBOL * ext_search(EXT_SYMBOL * ext_list, char * symbol_name);
+typedef struct FIXUP FIXUP;
 
+typedef struct FIXUP_LIST FIXUP_LIST;
+
+/*One unresolved operand recorded while encoding in the single-pass mode. The word was
+  left zero when it was emitted; after the whole file was read, resolve_fixups patches it
+  from the completed symbol table.*/
+struct FIXUP
+{
+    enum
+    {
+        fixup_inst_label,   /*A label operand word in the instruction image*/
+        fixup_inst_constant, /*A constant operand word in the instruction image*/
+        fixup_data_constant  /*A constant operand word in the data image*/
+    } kind;
+
+    int word_index; /*Index of the word to patch in its memory image*/
+    char *name;     /*Interned name of the symbol the word refers to*/
+    int line_num;   /*Line of the reference, for error messages and the defined-before check*/
+};
+
+/*A contiguous vector of the fixups recorded by the single-pass mode, in encoding order.
+  An empty list is all zeros and the vector is released with free.*/
+struct FIXUP_LIST
+{
+    FIXUP *fixups;
+    int count;
+    int capacity;
+};
 
 /*
  * Function: add_ext_address
  * --------------------------
  * Description:
- *   This function adds an external address to the external symbol list or updates an existing symbol with a new address.
+ *   This function records a reference to an external symbol, creating the symbol in the
+ *   hashed external index on its first reference.
  *
  * Parameters:
- *   - ext_list: Pointer to the pointer to the head of the external symbol list.
+ *   - curr_program: Pointer to the translation unit holding the external index and list.
  *   - symbol_name: Name of the symbol.
- *   - symbol_address: Address of the symbol.
+ *   - symbol_address: Address of the reference in the machine code.
  *
  * Returns:
  *   - NO_ERROS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
  */
 
-int add_ext_address(EXT_SYMBOL ** ext_list, char *symbol_name, int symbol_address);
+int add_ext_address(TRANSLATION_UNIT *curr_program, char *symbol_name, int symbol_address);
 
 /*
 * Function: second_pass
@@ -52,16 +68,57 @@ int add_ext_address(EXT_SYMBOL ** ext_list, char *symbol_name, int symbol_addres
  *
  * Parameters:
  *   - curr_program: Pointer to the translation unit hat contains all the information about the file (symbol table, instruction array and ect...).
- *   - am_file_name: Name of the assembly file being processed.
- *   - am_file: Pointer to the file containing the assembly code.
+ *   - am_file_name: Name of the assembly file being processed (used in error messages).
+ *   - ast_stream: The stream of parsed lines that the first pass collected.
  *
  * Returns:
  *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails, SYNTAX_OR_LOGIC_ERROR if there are logical errors.
  */
 
-int second_pass(TRANSLATION_UNIT *curr_program, char *am_file_name, FILE *am_file);
+int second_pass(TRANSLATION_UNIT *curr_program, char *am_file_name, AST_STREAM *ast_stream);
+
+/*
+ * Function: encode_line
+ * ----------------------
+ * Description:
+ *   Encodes one parsed instruction or directive line into the memory images of the
+ *   translation unit. When fixups is NULL, label and constant operands are resolved
+ *   from the symbol table immediately (the two-pass mode); when it is not NULL, they
+ *   are recorded as fixups and their words are left zero, so the line can be encoded
+ *   before the whole symbol table exists (the single-pass mode).
+ *
+ * Parameters:
+ *   - curr_program: Pointer to the translation unit receiving the encoded words.
+ *   - line_ast: The parsed line to encode.
+ *   - line_num: The number of the line in the am source (used in error messages).
+ *   - am_file_name: Name of the assembly file being processed (used in error messages).
+ *   - fixups: The fixup list of the single-pass mode, or NULL to resolve operands inline.
+ *   - err_flag: Set to SYNTAX_OR_LOGIC_ERROR when an operand cannot be resolved.
+ *
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
 
+int encode_line(TRANSLATION_UNIT *curr_program, LINE_AST *line_ast, int line_num, char *am_file_name, FIXUP_LIST *fixups, int *err_flag);
 
+/*
+ * Function: resolve_fixups
+ * -------------------------
+ * Description:
+ *   Patches every word the single-pass mode left unresolved, now that the symbol table
+ *   is complete: label words receive the address (or the external marking) of their
+ *   symbol and constant words receive the value of their constant, with the same
+ *   diagnostics the two-pass mode prints for undefined or late-defined symbols.
+ *
+ * Parameters:
+ *   - curr_program: Pointer to the translation unit holding the images and the symbol table.
+ *   - am_file_name: Name of the assembly file being processed (used in error messages).
+ *   - fixups: The fixups recorded while encoding, in encoding order.
+ *
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails, SYNTAX_OR_LOGIC_ERROR if a fixup cannot be resolved.
+ */
 
+int resolve_fixups(TRANSLATION_UNIT *curr_program, char *am_file_name, FIXUP_LIST *fixups);
 
 #endif
@@ -0,0 +1,65 @@
+#ifndef SOURCE_READER_H
+#define SOURCE_READER_H
+
+#include <stdio.h>
+
+#include "general.h"
+
+typedef struct SOURCE_READER SOURCE_READER;
+
+/*
+ * A reader over an input source file. For regular files the whole file is mapped into
+ * memory with mmap and lines are scanned directly out of the mapped region, which avoids
+ * the per-line buffered read path of fgets. For inputs that cannot be mapped (pipes and
+ * other non-seekable inputs) the reader falls back to a plain stdio stream.
+ */
+
+struct SOURCE_READER
+{
+    char *data;     /*The mapped content of the file, NULL when the fallback stream is used*/
+    long size;      /*The size of the mapped content in bytes*/
+    long pos;       /*The current reading position inside the mapped content*/
+    FILE *fallback; /*The stdio stream used when the input could not be mapped*/
+};
+
+/*
+ * Function: source_reader_open
+ * -----------------------------
+ * Description:
+ *   Opens a source file for line-by-line reading, preferring an mmap of the whole file.
+ * Parameters:
+ *   - reader: The reader to initialize.
+ *   - file_name: The name of the file to open.
+ * Returns:
+ *   - NO_ERRORS if the file was opened, SYNTAX_OR_LOGIC_ERROR if it cannot be opened.
+ */
+
+int source_reader_open(SOURCE_READER *reader, char *file_name);
+
+/*
+ * Function: source_reader_gets
+ * -----------------------------
+ * Description:
+ *   Reads the next line from the source, mirroring the behavior of fgets.
+ * Parameters:
+ *   - reader: The reader to read from.
+ *   - dest: The destination array into which the line is copied.
+ *   - max_len: The size of the destination array.
+ * Returns:
+ *   - dest if a line was read, or NULL if the end of the source was reached.
+ */
+
+char *source_reader_gets(SOURCE_READER *reader, char *dest, int max_len);
+
+/*
+ * Function: source_reader_close
+ * ------------------------------
+ * Description:
+ *   Releases the mapping or closes the fallback stream held by the reader.
+ * Parameters:
+ *   - reader: The reader to close.
+ */
+
+void source_reader_close(SOURCE_READER *reader);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef WRITER_THREAD_H
+#define WRITER_THREAD_H
+
+#include "general.h"
+#include "arena.h"
+#include "cache.h"
+
+#define WRITER_QUEUE_CAPACITY 8 /*Number of finished files the writer can hold before the assembling threads block*/
+
+typedef struct OUTPUT_JOB OUTPUT_JOB;
+
+/*
+ * The output work of one successfully assembled file, handed to the writer thread so
+ * the .ob, .ent and .ext files are flushed in the background while the next file is
+ * assembled. The job owns the translation unit vectors, the memory images and the
+ * per-file arena (the symbol and external names live in it); the writer releases all
+ * of them after the flush.
+ */
+
+struct OUTPUT_JOB
+{
+    TRANSLATION_UNIT unit;
+    char *file_name;                 /*The input file name, without the extension (an argv string)*/
+    int binary_obj_flag;             /*When different from 0, the object file is written in the binary format*/
+    char *cache_dir;                 /*Path of the cache directory, or NULL when --cache-dir was not given*/
+    char content_key[CACHE_KEY_LEN]; /*The cache key of the expanded source, valid when cache_dir is not NULL*/
+    ARENA arena;                     /*The per-file arena, released after the flush*/
+
+    /*The profile numbers of the passes, recorded by the writer together with the
+      back-end time it measures itself*/
+    double pre_seconds;
+    double first_seconds;
+    double second_seconds;
+    long symbol_lookups;
+    long symbol_probes;
+    long macro_lookups;
+    long macro_probes;
+};
+
+/*
+ * Function: writer_thread_start
+ * ------------------------------
+ * Description:
+ *   Starts the background writer thread. When the start fails, submitted jobs are
+ *   flushed synchronously by the submitting thread instead.
+ *
+ * Returns:
+ *   - NO_ERRORS if the thread was started, SYNTAX_OR_LOGIC_ERROR otherwise.
+ */
+
+int writer_thread_start(void);
+
+/*
+ * Function: writer_thread_submit
+ * -------------------------------
+ * Description:
+ *   Hands the output work of a finished file to the writer thread, blocking while the
+ *   queue is full. The job is copied into the queue, so the caller may reuse its
+ *   OUTPUT_JOB; the resources the job points to belong to the writer from this call on.
+ *
+ * Parameters:
+ *   - job: The output job to hand off.
+ */
+
+void writer_thread_submit(OUTPUT_JOB *job);
+
+/*
+ * Function: writer_thread_drain
+ * ------------------------------
+ * Description:
+ *   Blocks until every job submitted so far was flushed, without stopping the writer.
+ *   The server mode calls this before replying to a request, so the outputs of the
+ *   file are on disk when the client reads the status.
+ *
+ * Returns:
+ *   - NO_ERRORS when every flush since the previous drain succeeded, otherwise
+ *     SYNTAX_OR_LOGIC_ERROR; the flag is cleared for the next request.
+ */
+
+int writer_thread_drain(void);
+
+/*
+ * Function: writer_thread_finish
+ * -------------------------------
+ * Description:
+ *   Waits until every submitted job was flushed and stops the writer thread. Called
+ *   once at the end of the run, so the process never exits with outputs still queued.
+ */
+
+void writer_thread_finish(void);
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * File: output_writer.c
+ * ---------------------
+ * Description:
+ *   This file implements the buffered output writer of the back end. The object, entries
+ *   and externals files are first encoded completely into one in-memory buffer and then
+ *   written with a single write each, because many small formatted writes are the
+ *   bottleneck on network-backed output directories.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "include/general.h"
+#include "include/output_writer.h"
+
+/*
+ * Function: output_writer_init
+ * -----------------------------
+ * Description:
+ *   Initializes the writer and allocates its initial buffer.
+ * Parameters:
+ *   - writer: The writer to initialize.
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ */
+
+int output_writer_init(OUTPUT_WRITER *writer)
+{
+    writer->buffer = (char *)malloc(OUTPUT_WRITER_INITIAL_CAPACITY * sizeof(char));
+    writer->length = 0;
+    writer->capacity = OUTPUT_WRITER_INITIAL_CAPACITY;
+    writer->error_flag = 0;
+
+    if (writer->buffer == NULL)
+    {
+        writer->capacity = 0;
+        writer->error_flag = 1;
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    return NO_ERRORS;
+}
+
+/*
+ * Function: output_writer_reserve
+ * --------------------------------
+ * Description:
+ *   Makes sure the buffer has room for the requested number of additional characters,
+ *   doubling its capacity when needed. Sets the sticky error flag on failure.
+ * Parameters:
+ *   - writer: The writer whose buffer should be grown.
+ *   - extra: The number of additional characters that are about to be appended.
+ * Returns:
+ *   - NO_ERRORS if the room is available, MEMORY_ALLOCATION_ERROR otherwise.
+ */
+
+static int output_writer_reserve(OUTPUT_WRITER *writer, int extra)
+{
+    char *temp;
+
+    if (writer->error_flag)
+    {
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    while (writer->length + extra > writer->capacity)
+    {
+        writer->capacity *= 2;
+        temp = (char *)realloc(writer->buffer, writer->capacity * sizeof(char));
+
+        if (temp == NULL)
+        {
+            writer->error_flag = 1;
+            return MEMORY_ALLOCATION_ERROR;
+        }
+
+        writer->buffer = temp;
+    }
+
+    return NO_ERRORS;
+}
+
+/*
+ * Function: output_writer_put_char
+ * ---------------------------------
+ * Description:
+ *   Appends one character to the output buffer.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - c: The character to append.
+ */
+
+void output_writer_put_char(OUTPUT_WRITER *writer, char c)
+{
+    if (output_writer_reserve(writer, 1) == NO_ERRORS)
+    {
+        writer->buffer[writer->length] = c;
+        writer->length++;
+    }
+}
+
+/*
+ * Function: output_writer_put_string
+ * -----------------------------------
+ * Description:
+ *   Appends a null-terminated string to the output buffer.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - text: The string to append.
+ */
+
+void output_writer_put_string(OUTPUT_WRITER *writer, char *text)
+{
+    int text_length = strlen(text);
+
+    if (output_writer_reserve(writer, text_length) == NO_ERRORS)
+    {
+        memcpy(writer->buffer + writer->length, text, text_length * sizeof(char));
+        writer->length += text_length;
+    }
+}
+
+/*
+ * Function: output_writer_put_number
+ * -----------------------------------
+ * Description:
+ *   Appends the decimal digits of a number to the output buffer.
+ * Parameters:
+ *   - writer: The writer to append to.
+ *   - number: The number to append.
+ * Algorithm:
+ *   - Build the digits in reverse into a small local array by repeated division, then
+ *     append them in the correct order, so no printf formatting machinery is involved.
+ */
+
+void output_writer_put_number(OUTPUT_WRITER *writer, int number)
+{
+    char digits[12]; /*Enough for the decimal digits of any int and a sign*/
+    int digit_count = 0;
+
+    if (number < 0)
+    {
+        output_writer_put_char(writer, '-');
+        number = -number;
+    }
+
+    do
+    {
+        digits[digit_count] = (char)('0' + (number % 10));
+        digit_count++;
+        number /= 10;
+    } while (number > 0);
+
+    if (output_writer_reserve(writer, digit_count) == NO_ERRORS)
+    {
+        while (digit_count > 0)
+        {
+            digit_count--;
+            writer->buffer[writer->length] = digits[digit_count];
+            writer->length++;
+        }
+    }
+}
+
+/*
+ * Function: output_writer_flush
+ * ------------------------------
+ * Description:
+ *   Writes the whole buffer to the named file with a single write and releases the buffer.
+ * Parameters:
+ *   - writer: The writer to flush.
+ *   - out_file_name: The name of the output file.
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if an append failed earlier or the
+ *     file cannot be opened.
+ */
+
+int output_writer_flush(OUTPUT_WRITER *writer, char *out_file_name)
+{
+    FILE *out_file;
+
+    if (writer->error_flag)
+    {
+        printf("Error the file : %s , memory allocation failed \n", out_file_name);
+        free(writer->buffer);
+        writer->buffer = NULL;
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    out_file = fopen(out_file_name, "w");
+
+    if (out_file == NULL)
+    {
+        printf("Error the file : %s , cannot be opened\n", out_file_name);
+        free(writer->buffer);
+        writer->buffer = NULL;
+        return MEMORY_ALLOCATION_ERROR;
+    }
+
+    fwrite(writer->buffer, sizeof(char), writer->length, out_file);
+    fclose(out_file);
+
+    free(writer->buffer);
+    writer->buffer = NULL;
+    writer->length = 0;
+    writer->capacity = 0;
+
+    return NO_ERRORS;
+}
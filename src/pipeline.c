@@ -0,0 +1,321 @@
+/*
+ * File: pipeline.c
+ * ----------------
+ * Description:
+ *   This file implements the --pipeline mode, which overlaps macro expansion and
+ *   parsing for a single file. A producer thread runs the pre-assembler and pushes
+ *   every expanded line into a bounded ring buffer; the calling thread pops the lines
+ *   and parses them with create_ast_from_text into the AST stream, computing the memory
+ *   cells of each line on the way. When both sides finish, first_pass_from_stream runs
+ *   the symbol table work over the parsed stream with the complete macro table, so the
+ *   diagnostics and outputs are identical to the sequential mode.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "include/pipeline.h"
+#include "include/pre_assembler.h"
+#include "include/first_pass.h"
+#include "include/front_end.h"
+#include "include/arena.h"
+
+/*The arguments and the result of the producer thread running the pre-assembler*/
+typedef struct PIPELINE_PRODUCER
+{
+    char *file_name;
+    HASH_TABLE *macro_table;
+    int keep_am_flag;
+    PIPELINE_RING *ring;
+    ARENA *arena;
+    char *am_buffer;
+} PIPELINE_PRODUCER;
+
+/*
+ * Function: pipeline_ring_init
+ * -----------------------------
+ * Description:
+ *   Initializes an empty ring with its lock and condition variables.
+ *
+ * Parameters:
+ *   ring: The ring to initialize.
+ */
+
+static void pipeline_ring_init(PIPELINE_RING *ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->count = 0;
+    ring->done = 0;
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->not_full, NULL);
+    pthread_cond_init(&ring->not_empty, NULL);
+}
+
+/*
+ * Function: pipeline_ring_destroy
+ * --------------------------------
+ * Description:
+ *   Destroys the lock and condition variables of a ring.
+ *
+ * Parameters:
+ *   ring: The ring to destroy.
+ */
+
+static void pipeline_ring_destroy(PIPELINE_RING *ring)
+{
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->not_full);
+    pthread_cond_destroy(&ring->not_empty);
+}
+
+/*
+ * Function: pipeline_push_line
+ * -----------------------------
+ * Description:
+ *   Pushes one line into the ring, blocking while the ring is full.
+ *
+ * Parameters:
+ *   ring: The ring between the pre-assembler and the parser.
+ *   line: The line to push, at most MAX_LINE_LEN - 1 characters.
+ *   line_length: The length of the line, without the terminating null character.
+ */
+
+static void pipeline_push_line(PIPELINE_RING *ring, char *line, int line_length)
+{
+    pthread_mutex_lock(&ring->lock);
+
+    while (ring->count == PIPELINE_RING_CAPACITY)
+    {
+        pthread_cond_wait(&ring->not_full, &ring->lock);
+    }
+
+    memcpy(ring->lines[ring->tail], line, line_length);
+    ring->lines[ring->tail][line_length] = '\0';
+    ring->tail = (ring->tail + 1) % PIPELINE_RING_CAPACITY;
+    ring->count++;
+
+    pthread_cond_signal(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+/*
+ * Function: pipeline_push_text
+ * -----------------------------
+ * Description:
+ *   Splits a chunk of expanded source into lines and pushes each one into the ring.
+ *   A chunk is either a single source line or a whole macro body; every line of a
+ *   macro body ends with a newline, only the last line of the file may lack one.
+ *
+ * Parameters:
+ *   ring: The ring between the pre-assembler and the parser.
+ *   text: The chunk to push.
+ */
+
+void pipeline_push_text(PIPELINE_RING *ring, char *text)
+{
+    char *line_start = text;
+    char *line_end;
+
+    while (*line_start != '\0')
+    {
+        line_end = strchr(line_start, '\n');
+
+        if (line_end == NULL)
+        {
+            pipeline_push_line(ring, line_start, strlen(line_start));
+            return;
+        }
+
+        pipeline_push_line(ring, line_start, (line_end - line_start) + 1);
+        line_start = line_end + 1;
+    }
+}
+
+/*
+ * Function: pipeline_finish
+ * --------------------------
+ * Description:
+ *   Marks the ring as finished, so the consumer stops after draining the buffered lines.
+ *
+ * Parameters:
+ *   ring: The ring between the pre-assembler and the parser.
+ */
+
+static void pipeline_finish(PIPELINE_RING *ring)
+{
+    pthread_mutex_lock(&ring->lock);
+    ring->done = 1;
+    pthread_cond_broadcast(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+/*
+ * Function: pipeline_pop
+ * -----------------------
+ * Description:
+ *   Pops the next line from the ring, blocking while the ring is empty and the
+ *   producer is still running.
+ *
+ * Parameters:
+ *   ring: The ring between the pre-assembler and the parser.
+ *   line: Output buffer of MAX_LINE_LEN characters receiving the line.
+ *
+ * Returns:
+ *   1 when a line was popped, 0 when the producer finished and the ring is drained.
+ */
+
+static int pipeline_pop(PIPELINE_RING *ring, char *line)
+{
+    pthread_mutex_lock(&ring->lock);
+
+    while (ring->count == 0 && ring->done == 0)
+    {
+        pthread_cond_wait(&ring->not_empty, &ring->lock);
+    }
+
+    if (ring->count == 0)
+    {
+        pthread_mutex_unlock(&ring->lock);
+        return 0;
+    }
+
+    strcpy(line, ring->lines[ring->head]);
+    ring->head = (ring->head + 1) % PIPELINE_RING_CAPACITY;
+    ring->count--;
+
+    pthread_cond_signal(&ring->not_full);
+    pthread_mutex_unlock(&ring->lock);
+    return 1;
+}
+
+/*
+ * Function: producer_main
+ * ------------------------
+ * Description:
+ *   Entry point of the producer thread. It installs the arena of the producer so the
+ *   pre-assembler allocations do not race with the parsing thread, runs the streaming
+ *   pre-assembler, and marks the ring as finished whether it succeeded or not.
+ *
+ * Parameters:
+ *   arg: Pointer to the PIPELINE_PRODUCER arguments.
+ *
+ * Returns:
+ *   NULL.
+ */
+
+static void *producer_main(void *arg)
+{
+    PIPELINE_PRODUCER *producer = (PIPELINE_PRODUCER *)arg;
+
+    arena_set_current(producer->arena);
+    producer->am_buffer = pre_assembly_streamed(producer->file_name, producer->macro_table,
+                                                producer->keep_am_flag, producer->ring);
+    arena_set_current(NULL);
+
+    pipeline_finish(producer->ring);
+    return NULL;
+}
+
+/*
+ * Function: pipelined_pre_assembly
+ * ---------------------------------
+ * Description:
+ *   Overlaps macro expansion and parsing. The producer thread expands the file and
+ *   pushes every expanded line into the ring; this thread pops the lines, parses them
+ *   and computes their memory cells, appending the lines the passes need (instructions,
+ *   directives, constant definitions and errors) to the AST stream in source order.
+ *
+ * Parameters:
+ *   file_name: The name of the input file, without the .as extension.
+ *   macro_table: The hash table that receives the macro definitions.
+ *   keep_am_flag: When different from 0, the expanded source is also written to a .am file.
+ *   ast_stream: The stream that receives the parsed lines.
+ *   producer_arena: The arena serving the allocations of the producer thread.
+ *
+ * Returns:
+ *   The macro-expanded source buffer (owned by the caller), or NULL if an error occurred.
+ *
+ * Algorithm:
+ *   1. Start the producer thread running the streaming pre-assembler.
+ *   2. Pop each expanded line, parse it and append it to the AST stream with its
+ *      memory cell count.
+ *   3. On an allocation failure, keep draining the ring so the producer never blocks
+ *      forever, then report the failure.
+ *   4. Join the producer and return the expanded source it built.
+ */
+
+char *pipelined_pre_assembly(char *file_name, HASH_TABLE *macro_table, int keep_am_flag,
+                             AST_STREAM *ast_stream, ARENA *producer_arena)
+{
+    PIPELINE_RING ring;
+    PIPELINE_PRODUCER producer;
+    pthread_t producer_thread;
+    char line[MAX_LINE_LEN];
+    LINE_AST line_ast;
+    int line_num = 1;
+    int cells;
+    int failed = 0;
+
+    pipeline_ring_init(&ring);
+
+    producer.file_name = file_name;
+    producer.macro_table = macro_table;
+    producer.keep_am_flag = keep_am_flag;
+    producer.ring = &ring;
+    producer.arena = producer_arena;
+    producer.am_buffer = NULL;
+
+    if (pthread_create(&producer_thread, NULL, producer_main, &producer) != 0)
+    {
+        printf("Error in file : %s , failed to create the pre-assembler thread\n", file_name);
+        pipeline_ring_destroy(&ring);
+        return NULL;
+    }
+
+    while (pipeline_pop(&ring, line))
+    {
+        if (failed)
+        {
+            continue; /*Keep draining so the producer never blocks on a full ring*/
+        }
+
+        parse_line_into(&line_ast, line);
+
+        if (line_ast.type == dir || line_ast.type == inst ||
+            line_ast.type == constant_def || line_ast.type == error)
+        {
+            cells = 0;
+
+            /*The cell count only matters for lines that occupy memory; computing it here
+              keeps it overlapped with the macro expansion*/
+            if (line_ast.type == inst ||
+                (line_ast.type == dir && (line_ast.operand.directive.type == data ||
+                                          line_ast.operand.directive.type == string)))
+            {
+                cells = memory_cell_calculator(line_ast);
+            }
+
+            if (ast_stream_append(ast_stream, &line_ast, line_num, cells) == MEMORY_ALLOCATION_ERROR)
+            {
+                failed = 1;
+            }
+        }
+
+        line_num++;
+    }
+
+    pthread_join(producer_thread, NULL);
+    pipeline_ring_destroy(&ring);
+
+    if (failed)
+    {
+        printf("Error in file : %s , memory allocation failed\n", file_name);
+        free(producer.am_buffer);
+        return NULL;
+    }
+
+    return producer.am_buffer;
+}
@@ -3,18 +3,17 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include "include/pre_assembler.h"
-
-struct TEXT
-{
-    char *text;
-    struct TEXT *next;
-};
+#include "include/source_reader.h"
+#include "include/pipeline.h"
+#include "include/arena.h"
+#include "include/diag.h"
 
 struct MACRO
 {
     char *name;
-    TEXT *content;
-    struct MACRO *next;
+    char *content;        /*The whole macro body as one contiguous buffer, so a call expands with a single copy*/
+    int content_length;   /*Length of the body, without the terminating null character*/
+    int content_capacity; /*Allocated capacity of the body buffer*/
 };
 
 enum
@@ -27,6 +26,15 @@ enum
     any_other_line
 } line_type;
 
+static int append_text(char **buffer, int *length, int *capacity, char *text);
+
+/*The shared macro library loaded once with --macro-lib. It is filled before any file is
+  assembled and read-only afterwards, so the worker threads of the -j mode consult it
+  without locking. Lookups fall back to it after missing the per-file table.*/
+static HASH_TABLE library_table;
+static MACRO_FILTER library_filter;
+static int library_loaded = 0;
+
 /*
  * Function: macro_lookup
  * -----------------------
@@ -34,30 +42,112 @@ enum
  *
  * Parameters:
  *   name: The name of the macro to lookup.
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
  *
  * Returns:
  *   A pointer to the found macro if it exists, otherwise NULL.
  *
  * Algorithm:
- *   1. Calculate the hash index for the given macro name.
- *   2. Traverse the linked list at the calculated index to find the macro.
+ *   1. Probe the open-addressing hash table for the given name.
+ *   2. Return a pointer to the macro if found, otherwise return NULL.
  */
 
-MACRO *macro_lookup(char *name, MACRO *macro_table[HASH_TABLE_SIZE])
+MACRO *macro_lookup(char *name, HASH_TABLE *macro_table)
 {
-    unsigned int index = hash(name);
-    MACRO *current = macro_table[index];
-    while (current != NULL)
+    MACRO *found = (MACRO *)hash_table_lookup(macro_table, name);
+
+    /*Names missing from the per-file table may still be defined by the shared library*/
+    if (found == NULL && library_loaded)
     {
-        if (strcmp(name, current->name) == 0)
-        {
-            return current;
-        }
+        found = (MACRO *)hash_table_lookup(&library_table, name);
+    }
+
+    return found;
+}
+
+/*
+ * Function: macro_filter_init
+ * ----------------------------
+ * Initializes the macro call pre-filter of one file. With a loaded macro library the
+ * filter starts as a copy of the library filter, so calls to library macros pass the
+ * cheap check; without one it starts empty.
+ *
+ * Parameters:
+ *   filter: The filter to initialize.
+ */
+
+static void macro_filter_init(MACRO_FILTER *filter)
+{
+    if (library_loaded)
+    {
+        *filter = library_filter;
+    }
 
-        current = current->next;
+    else
+    {
+        memset(filter, 0, sizeof(MACRO_FILTER));
     }
-    return current;
+}
+
+/*
+ * Function: macro_filter_may_match
+ * ---------------------------------
+ * Checks whether a word can possibly name a defined macro, without touching the macro
+ * table: the bit of its first character must be set in the bitmap and its length must
+ * lie within the bounds of the defined macro names. Almost every line starts with a
+ * word that is not a macro call, so this rejects the common case with two comparisons
+ * and one bit test instead of a hash lookup.
+ *
+ * Parameters:
+ *   filter: The macro call pre-filter maintained by insert_macro.
+ *   word: The first character of the word to test (a span inside the line, not terminated).
+ *   word_length: The length of the word.
+ *
+ * Returns:
+ *   1 when the word may be a macro name, 0 when it certainly is not.
+ */
+
+static int macro_filter_may_match(MACRO_FILTER *filter, char *word, int word_length)
+{
+    if ((filter->first_chars[(unsigned char)word[0] >> 3] & (1 << ((unsigned char)word[0] & 7))) == 0)
+    {
+        return 0;
+    }
+
+    return (word_length >= filter->min_length) && (word_length <= filter->max_length);
+}
+
+/*
+ * Function: macro_call_lookup
+ * ----------------------------
+ * Looks a word span up in the macro table as a possible macro call. The pre-filter
+ * rejects almost every word with a bit test and two comparisons; only a filter hit
+ * pays for the terminated stack copy the hashed lookup needs, so the line buffer is
+ * never copied for ordinary words.
+ *
+ * Parameters:
+ *   span: The first character of the word inside the line.
+ *   span_length: The length of the word.
+ *   filter: The macro call pre-filter maintained by insert_macro.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *
+ * Returns:
+ *   The macro the word names, or NULL when it names none.
+ */
+
+static MACRO *macro_call_lookup(char *span, int span_length, MACRO_FILTER *filter, HASH_TABLE *macro_table)
+{
+    char name_buffer[MAX_LINE_LEN];
+
+    if (macro_filter_may_match(filter, span, span_length) == 0)
+    {
+        return NULL;
+    }
+
+    memcpy(name_buffer, span, span_length);
+    name_buffer[span_length] = '\0';
+
+    return macro_lookup(name_buffer, macro_table);
 }
 
 /*
@@ -67,53 +157,64 @@ MACRO *macro_lookup(char *name, MACRO *macro_table[HASH_TABLE_SIZE])
  *
  * Parameters:
  *   macro_name: The name of the macro to insert.
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   filter: The macro call pre-filter, updated with the new name.
  *   file_name: The name of the source file.
  *
  * Returns:
  *   A pointer to the macro if created successfully, otherwise returns NULL.
  *
  * Algorithm:
- *   1. Calculate the hash index for the given macro name.
- *   2. Allocate memory for the new macro.
- *   3. Insert the macro into the hash table at the calculated index.
+ *   1. Allocate memory for the new macro from the per-file arena.
+ *   2. Copy the macro name into it.
+ *   3. Insert the macro into the open-addressing hash table.
+ *   4. Record the first character and the length of the name in the pre-filter.
  */
 
-MACRO *insert_macro(char *macro_name, MACRO *macro_table[HASH_TABLE_SIZE], char *file_name)
+MACRO *insert_macro(char *macro_name, HASH_TABLE *macro_table, MACRO_FILTER *filter, char *file_name)
 {
-    unsigned int index = hash(macro_name);
-    MACRO *new_macro = (MACRO *)malloc(sizeof(MACRO));
+    int name_length;
+    MACRO *new_macro = (MACRO *)arena_alloc_current(sizeof(MACRO));
 
     if (new_macro == NULL)
     {
-        printf("Error in file : %s , memory allocation failed\n", file_name);
+        diag_error("Error in file : %s , memory allocation failed\n", file_name);
         return NULL;
     }
 
-    new_macro->name = (char *)malloc((strlen(macro_name) + 1) * sizeof(char));
+    new_macro->name = (char *)arena_alloc_current((strlen(macro_name) + 1) * sizeof(char));
     if (new_macro->name == NULL)
     {
-        printf("Error in file : %s , memory allocation failed\n", file_name);
-        free(new_macro);
+        diag_error("Error in file : %s , memory allocation failed\n", file_name);
         return NULL;
     }
     strcpy(new_macro->name, macro_name);
 
     new_macro->content = NULL;
-    new_macro->next = NULL;
+    new_macro->content_length = 0;
+    new_macro->content_capacity = 0;
 
-    if (macro_table[index] == NULL)
+    if (hash_table_insert(macro_table, new_macro->name, new_macro) == MEMORY_ALLOCATION_ERROR)
     {
-        macro_table[index] = new_macro;
-        return new_macro;
+        diag_error("Error in file : %s , memory allocation failed\n", file_name);
+        return NULL;
     }
 
-    else
+    /*Teach the pre-filter the new name, so calls to it pass the cheap check*/
+    filter->first_chars[(unsigned char)macro_name[0] >> 3] |= 1 << ((unsigned char)macro_name[0] & 7);
+    name_length = strlen(macro_name);
+
+    if (filter->min_length == 0 || name_length < filter->min_length)
+    {
+        filter->min_length = name_length;
+    }
+
+    if (name_length > filter->max_length)
     {
-        new_macro->next = macro_table[index];
-        macro_table[index] = new_macro;
-        return new_macro;
+        filter->max_length = name_length;
     }
+
+    return new_macro;
 }
 
 /*
@@ -131,49 +232,31 @@ MACRO *insert_macro(char *macro_name, MACRO *macro_table[HASH_TABLE_SIZE], char
  *   NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
  *
  * Algorithm:
- *   1. Allocate memory for the new TEXT node.
- *   2. Copy the line of text into the TEXT node.
- *   3. Insert the TEXT node into end of the content linked list of the specified macro.
+ *   1. Allocate the body buffer of the macro on the first inserted line.
+ *   2. Append the line to the end of the buffer, doubling its capacity when needed.
  */
 
 int text_insert(MACRO *macro, char *line, char *file_name, int line_num)
 {
-    TEXT *content_ptr = NULL;
-    TEXT *added_line = (TEXT *)malloc(sizeof(TEXT));
-    if (added_line == NULL)
-    {
-        printf("Error in file : %s , memory allocation failed\n", file_name);
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    added_line->text = (char *)malloc((strlen(line) + 1) * sizeof(char));
-    if (added_line->text == NULL)
-    {
-        printf("Error in file : %s , memory allocation failed \n", file_name);
-        free(added_line);
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    else
-    {
-        strcpy(added_line->text, line);
-        added_line->next = NULL;
-    }
-
     if (macro->content == NULL)
     {
-        macro->content = added_line;
-    }
+        macro->content = (char *)malloc(MACRO_CONTENT_INITIAL_CAPACITY * sizeof(char));
 
-    else
-    {
-        content_ptr = macro->content;
-        while (content_ptr->next != NULL)
+        if (macro->content == NULL)
         {
-            content_ptr = content_ptr->next;
+            diag_error("Error in file : %s , memory allocation failed\n", file_name);
+            return MEMORY_ALLOCATION_ERROR;
         }
 
-        content_ptr->next = added_line;
+        macro->content[0] = '\0';
+        macro->content_length = 0;
+        macro->content_capacity = MACRO_CONTENT_INITIAL_CAPACITY;
+    }
+
+    if (append_text(&macro->content, &macro->content_length, &macro->content_capacity, line) == MEMORY_ALLOCATION_ERROR)
+    {
+        diag_error("Error in file : %s , memory allocation failed \n", file_name);
+        return MEMORY_ALLOCATION_ERROR;
     }
 
     return NO_ERRORS;
@@ -187,7 +270,8 @@ int text_insert(MACRO *macro, char *line, char *file_name, int line_num)
  * Parameters:
  *   line: The line of text being processed.
  *   mcr_ptr: Pointer to the current macro (if any).
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   filter: The macro call pre-filter, consulted before the table lookup.
  *   file_name: The name of the source file.
  *   line_num: The line number being processed.
  *
@@ -214,33 +298,31 @@ int text_insert(MACRO *macro, char *line, char *file_name, int line_num)
  *
  */
 
-int line_identifier(char *line, MACRO **mcr_ptr, MACRO *macro_table[HASH_TABLE_SIZE], char *file_name, int line_num)
+int line_identifier(char *line, MACRO **mcr_ptr, HASH_TABLE *macro_table, MACRO_FILTER *filter, char *file_name, int line_num)
 {
 
     int word_cnt = 0;
     int mcr_definition = 0;
     int end_mcr = 0;
-    char *word;
+    char *span;
+    int span_length;
     char *macro_name = NULL;
     MACRO *temp_mcr = NULL;
 
-    while ((word = get_word(&line)) != NULL)
+    while ((span = get_word_span(&line, &span_length)) != NULL)
     {
         word_cnt++;
 
-        if (word_cnt == 1 && word[0] == ';')
+        if (word_cnt == 1 && span[0] == ';')
         {
-            free(word);
             return note_sentence;
         }
 
-        if (strcmp(word, "mcr") == 0) /*Start of macro defenition*/
+        if (span_equals(span, span_length, "mcr")) /*Start of macro defenition*/
         {
             if (word_cnt > 1) /*Start of macro_defenition that is not in the begening of the line */
             {
-                printf("Error in file : %s , line number: %d ,  macro definition must be at the beginning of the line \n", file_name, line_num);
-                free(macro_name);
-                free(word);
+                diag_error("Error in file : %s , line number: %d ,  macro definition must be at the beginning of the line \n", file_name, line_num);
                 return error;
             }
 
@@ -254,127 +336,167 @@ int line_identifier(char *line, MACRO **mcr_ptr, MACRO *macro_table[HASH_TABLE_S
         {
             if (word_cnt == 2)
             {
-                macro_name = (char *)malloc((strlen(word) + 1) * sizeof(char));
+                /*The macro name outlives the line, so this is the one copied word*/
+                macro_name = (char *)arena_alloc_current((span_length + 1) * sizeof(char));
                 if (macro_name == NULL)
                 {
-                    printf("Error in file : %s ,memory allocation failed \n", file_name);
-                    free(word);
+                    diag_error("Error in file : %s ,memory allocation failed \n", file_name);
                     return error;
                 }
 
-                strcpy(macro_name, word);
+                memcpy(macro_name, span, span_length);
+                macro_name[span_length] = '\0';
 
                 if ((macro_lookup(macro_name, macro_table)) != NULL)
                 {
-                    printf("Error in file : %s , line number: %d , attempt to define a macro with the name of a macro that already exists \n", file_name, line_num);
-                    free(macro_name);
-                    free(word);
+                    diag_error("Error in file : %s , line number: %d , attempt to define a macro with the name of a macro that already exists \n", file_name, line_num);
                     return error;
                 }
 
                 if (is_directive(macro_name) > -1 || is_operation(macro_name) > -1)
                 {
-                    printf("Error in file : %s , line number: %d , the macro was given the name of a directive or instruction \n", file_name, line_num);
-                    free(macro_name);
-                    free(word);
+                    diag_error("Error in file : %s , line number: %d , the macro was given the name of a directive or instruction \n", file_name, line_num);
                     return error;
                 }
             }
 
             if (word_cnt > 2)
             {
-                printf("Error in file : %s , line number: %d , there are words in the line of the macro definition except the macro name and mcr \n", file_name, line_num);
-                free(macro_name);
-                free(word);
+                diag_error("Error in file : %s , line number: %d , there are words in the line of the macro definition except the macro name and mcr \n", file_name, line_num);
                 return error;
             }
         }
 
-        else if (strcmp(word, "endmcr") == 0)
+        else if (span_equals(span, span_length, "endmcr"))
         {
 
             end_mcr = 1;
         }
 
-        else if ((temp_mcr = macro_lookup(word, macro_table)) != NULL)
+        else if ((temp_mcr = macro_call_lookup(span, span_length, filter, macro_table)) != NULL)
         {
             *mcr_ptr = temp_mcr;
-            free(macro_name);
-            free(word);
             return macro_call;
         }
 
         else if (end_mcr && word_cnt > 1)
         {
-            printf("Error in file : %s , line number: %d , text exists on the same line after endmcr \n", file_name, line_num);
-            free(macro_name);
-            free(word);
+            diag_error("Error in file : %s , line number: %d , text exists on the same line after endmcr \n", file_name, line_num);
             return error;
         }
 
-        free(word);
     }
 
-    if (line[0] == '\0')
+    /*The span loop only ends at the end of the line, so the line is fully consumed here*/
+    if (mcr_definition)
     {
+        if (word_cnt == 1)
+        {
+            diag_error("Error in file : %s , line number: %d , defining a macro without giving a name\n", file_name, line_num);
+            return error;
+        }
 
-        if (mcr_definition)
+        else
         {
-            if (word_cnt == 1)
+            if ((temp_mcr = macro_lookup(macro_name, macro_table)) == NULL)
             {
-                printf("Error in file : %s , line number: %d , defining a macro without giving a name\n", file_name, line_num);
-                free(macro_name);
-                return error;
-            }
 
-            else
-            {
-                if ((temp_mcr = macro_lookup(macro_name, macro_table)) == NULL)
+                *mcr_ptr = insert_macro(macro_name, macro_table, filter, file_name);
+                if (*mcr_ptr == NULL)
                 {
-
-                    *mcr_ptr = insert_macro(macro_name, macro_table, file_name);
-                    if (*mcr_ptr == NULL)
-                    {
-                        free(macro_name);
-                        return error;
-                    }
-
-                    else
-                    {
-                        free(macro_name);
-                        return macro_definition;
-                    }
+                    return error;
                 }
 
                 else
                 {
-                    free(macro_name);
-                    return error;
+                    return macro_definition;
                 }
             }
+
+            else
+            {
+                return error;
+            }
         }
+    }
 
-        else if (end_mcr)
-        {
+    else if (end_mcr)
+    {
 
-            *mcr_ptr = NULL;
-            free(macro_name);
-            return end_macro_definition;
-        }
+        *mcr_ptr = NULL;
+        return end_macro_definition;
+    }
 
-        else
+    else
+    {
+        return any_other_line;
+    }
+}
+
+/*
+ * Function: append_text
+ * ----------------------
+ * Appends a string to the end of a dynamically growing buffer.
+ *
+ * Parameters:
+ *   buffer: Pointer to the buffer to append to (may be reallocated).
+ *   length: Pointer to the current length of the buffer content.
+ *   capacity: Pointer to the current allocated capacity of the buffer.
+ *   text: The string to append.
+ *
+ * Returns:
+ *   NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
+ *
+ * Algorithm:
+ *   1. Double the capacity of the buffer until the new text fits.
+ *   2. Copy the text (including the terminating null character) to the end of the buffer.
+ */
+
+static int append_text(char **buffer, int *length, int *capacity, char *text)
+{
+    int text_length = strlen(text);
+    char *temp;
+
+    while ((*length) + text_length + 1 > (*capacity))
+    {
+        (*capacity) *= 2;
+        temp = (char *)realloc(*buffer, (*capacity) * sizeof(char));
+        if (temp == NULL)
         {
-            free(macro_name);
-            return any_other_line;
+            return MEMORY_ALLOCATION_ERROR;
         }
+
+        *buffer = temp;
     }
 
-    else /*failed memory allocation in get_word function*/
+    memcpy((*buffer) + (*length), text, (text_length + 1) * sizeof(char));
+    *length += text_length;
+    return NO_ERRORS;
+}
+
+/*
+ * Function: pre_assembly_cleanup
+ * -------------------------------
+ * Releases the resources held by pre_assembly when an error occurred.
+ *
+ * Parameters:
+ *   as_reader: The reader over the input assembly file (closed).
+ *   am_file: The optional .am debug file, may be NULL (closed and removed).
+ *   as_file_name: The name of the input file (freed).
+ *   am_file_name: The name of the .am file, may be NULL (freed).
+ *   am_buffer: The in-memory expanded source buffer, may be NULL (freed).
+ */
+
+static void pre_assembly_cleanup(SOURCE_READER *as_reader, FILE *am_file, char *as_file_name, char *am_file_name, char *am_buffer)
+{
+    if (am_file != NULL)
     {
-        printf("Error in file : %s , memory allocation failed\n", file_name);
-        free(macro_name);
-        return error;
+        fclose(am_file);
+        remove(am_file_name);
     }
+
+    source_reader_close(as_reader);
+    free(am_buffer);
 }
 
 /*
@@ -384,91 +506,109 @@ int line_identifier(char *line, MACRO **mcr_ptr, MACRO *macro_table[HASH_TABLE_S
  *
  * Parameters:
  *   file_name: The name of the assembly file.
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   keep_am_flag: When different from 0, the expanded source is also written to a .am file (debug aid).
+ *   sink: When not NULL, every expanded line is also pushed into this ring, so the
+ *         parsing thread of the --pipeline mode consumes the lines while they are produced.
  *
  * Returns:
- *   A pointer to the name of the processed assembly file.
+ *   A pointer to a dynamically allocated buffer containing the macro-expanded source,
+ *   or NULL if an error occurred. The caller is responsible for freeing the buffer.
  *
  * Algorithm:
- *   1. Open the input assembly file for reading and create an output file for writing.
+ *   1. Open the input assembly file through the source reader (mmap for regular files) and allocate an in-memory output buffer.
  *   2. Read each line from the input file and process it accordingly.
  *   3. Identify macro definitions, calls, and other lines using line_identifier function.
- *   4. Expand macros and write the processed lines to the output file.
- *   5. Close both input and output files.
+ *   4. Expand macros and append the processed lines to the output buffer.
+ *   5. If keep_am_flag is set, also write the expanded source to a .am file.
+ *   6. Close the input file and return the buffer.
  */
 
-char *pre_assembly(char *file_name, MACRO *macro_table[HASH_TABLE_SIZE])
+static char *pre_assembly_expand(char *file_name, HASH_TABLE *macro_table, int keep_am_flag, PIPELINE_RING *sink)
 {
 
-    FILE *as_file;
-    FILE *am_file;
+    SOURCE_READER as_reader;
+    FILE *am_file = NULL;
     char *as_file_name;
-    char *am_file_name;
+    char *am_file_name = NULL;
+    char *am_buffer;
+    int am_buffer_length = 0;
+    int am_buffer_capacity = AM_BUFFER_INITIAL_CAPACITY;
     int line_num = 1;
     char line[MAX_LINE_LEN] = {0};
-    TEXT *content_ptr = NULL;
     MACRO *mcr_ptr = NULL;
+    MACRO_FILTER macro_filter;
     int mcr_def_flag = 0;
+    int append_result = NO_ERRORS;
 
     /*creating the file names*/
 
     as_file_name = dynamic_strcat(file_name, ".as");
-    am_file_name = dynamic_strcat(file_name, ".am");
 
-    if (as_file_name == NULL || am_file_name == NULL)
+    if (as_file_name == NULL)
     {
-        printf("Error in file : %s ,memory allocation failed\n", file_name);
-        free(as_file_name);
-        free(am_file_name);
+        diag_error("Error in file : %s ,memory allocation failed\n", file_name);
         return NULL;
     }
 
-    /*opening the files*/
+    /*opening the input file*/
 
-    as_file = fopen(as_file_name, "r");
-
-    if (as_file == NULL)
+    if (source_reader_open(&as_reader, as_file_name) != NO_ERRORS)
     {
-        printf("Error in file : %s , cannot be opened\n", as_file_name);
-        free(as_file_name);
-        free(am_file_name);
+        diag_error("Error in file : %s , cannot be opened\n", as_file_name);
         return NULL;
     }
 
-    am_file = fopen(am_file_name, "w");
+    /*The am file is only created when it was requested as a debug aid*/
+    if (keep_am_flag)
+    {
+        am_file_name = dynamic_strcat(file_name, ".am");
+
+        if (am_file_name == NULL)
+        {
+            diag_error("Error in file : %s ,memory allocation failed\n", file_name);
+            source_reader_close(&as_reader);
+            return NULL;
+        }
+
+        am_file = fopen(am_file_name, "w");
+
+        if (am_file == NULL)
+        {
+            diag_error("Error in file : %s , cannot be opened\n", am_file_name);
+            source_reader_close(&as_reader);
+            return NULL;
+        }
+    }
+
+    am_buffer = (char *)malloc(am_buffer_capacity * sizeof(char));
 
-    if (am_file == NULL)
+    if (am_buffer == NULL)
     {
-        printf("Error in file : %s , cannot be opened\n", am_file_name);
-        free(as_file_name);
-        free(am_file_name);
-        fclose(as_file);
+        diag_error("Error in file : %s ,memory allocation failed\n", file_name);
+        pre_assembly_cleanup(&as_reader, am_file, as_file_name, am_file_name, NULL);
         return NULL;
     }
 
-    while (fgets(line, MAX_LINE_LEN, as_file) != NULL) /*keep reading line until EOF*/
+    am_buffer[0] = '\0';
+
+    macro_filter_init(&macro_filter);
+
+    while (source_reader_gets(&as_reader, line, MAX_LINE_LEN) != NULL) /*keep reading line until EOF*/
     {
         /*Checking if the line contains more than 80 characters*/
         if ((strchr(line, '\n') == NULL) && (strchr(line, EOF)))
         {
-            printf("Error in file : %s , line number: %d,  The line contains over 80 characters\n", as_file_name, line_num);
-            fclose(am_file);
-            fclose(as_file);
-            remove(am_file_name);
-            free(am_file_name);
-            free(as_file_name);
+            diag_error("Error in file : %s , line number: %d,  The line contains over 80 characters\n", as_file_name, line_num);
+            pre_assembly_cleanup(&as_reader, am_file, as_file_name, am_file_name, am_buffer);
             return NULL;
         }
 
-        switch (line_identifier(line, &mcr_ptr, macro_table, as_file_name, line_num))
+        switch (line_identifier(line, &mcr_ptr, macro_table, &macro_filter, as_file_name, line_num))
         {
         case error: /*The line_identifier function print the error type*/
 
-            fclose(am_file);
-            fclose(as_file);
-            remove(am_file_name);
-            free(am_file_name);
-            free(as_file_name);
+            pre_assembly_cleanup(&as_reader, am_file, as_file_name, am_file_name, am_buffer);
             return NULL;
 
             break;
@@ -483,18 +623,36 @@ char *pre_assembly(char *file_name, MACRO *macro_table[HASH_TABLE_SIZE])
 
         case macro_call: /*The line_identifier function change mcr_ptr to point to the relevant macro*/
 
-            content_ptr = mcr_ptr->content;
-            mcr_ptr = NULL;
-            while (content_ptr)
+            /*The whole body is one contiguous buffer, so the call expands with a single copy*/
+            if (mcr_ptr->content != NULL)
             {
-                fputs(content_ptr->text, am_file);
-                content_ptr = content_ptr->next;
+                append_result = append_text(&am_buffer, &am_buffer_length, &am_buffer_capacity, mcr_ptr->content);
+
+                if ((am_file != NULL) && (append_result != MEMORY_ALLOCATION_ERROR))
+                {
+                    fputs(mcr_ptr->content, am_file);
+                }
+
+                if ((sink != NULL) && (append_result != MEMORY_ALLOCATION_ERROR))
+                {
+                    pipeline_push_text(sink, mcr_ptr->content);
+                }
             }
 
+            mcr_ptr = NULL;
             break;
 
         case note_sentence:
-            fputs(line, am_file);
+            append_result = append_text(&am_buffer, &am_buffer_length, &am_buffer_capacity, line);
+            if (am_file != NULL)
+            {
+                fputs(line, am_file);
+            }
+
+            if ((sink != NULL) && (append_result != MEMORY_ALLOCATION_ERROR))
+            {
+                pipeline_push_text(sink, line);
+            }
 
             break;
 
@@ -504,67 +662,113 @@ char *pre_assembly(char *file_name, MACRO *macro_table[HASH_TABLE_SIZE])
             {
                 if (text_insert(mcr_ptr, line, as_file_name, line_num) == MEMORY_ALLOCATION_ERROR)
                 {
-                    fclose(am_file);
-                    fclose(as_file);
-                    remove(am_file_name);
-                    free(am_file_name);
-                    free(as_file_name);
+                    pre_assembly_cleanup(&as_reader, am_file, as_file_name, am_file_name, am_buffer);
                     return NULL;
                 }
             }
 
             else
             {
-                fputs(line, am_file);
+                append_result = append_text(&am_buffer, &am_buffer_length, &am_buffer_capacity, line);
+                if (am_file != NULL)
+                {
+                    fputs(line, am_file);
+                }
+
+                if ((sink != NULL) && (append_result != MEMORY_ALLOCATION_ERROR))
+                {
+                    pipeline_push_text(sink, line);
+                }
             }
 
             break;
         }
+
+        if (append_result == MEMORY_ALLOCATION_ERROR)
+        {
+            diag_error("Error in file : %s ,memory allocation failed\n", file_name);
+            pre_assembly_cleanup(&as_reader, am_file, as_file_name, am_file_name, am_buffer);
+            return NULL;
+        }
+
         line_num++;
     }
 
     if (mcr_def_flag == 1)
     {
-        printf("Error in file : %s , a macro is defined without closing, i.e. without end_mcr\n", as_file_name);
-        fclose(am_file);
-        fclose(as_file);
-        remove(am_file_name);
-        free(am_file_name);
-        free(as_file_name);
+        diag_error("Error in file : %s , a macro is defined without closing, i.e. without end_mcr\n", as_file_name);
+        pre_assembly_cleanup(&as_reader, am_file, as_file_name, am_file_name, am_buffer);
         return NULL;
     }
 
-    fclose(am_file);
-    fclose(as_file);
-    free(as_file_name);
+    if (am_file != NULL)
+    {
+        fclose(am_file);
+    }
 
-    return am_file_name;
+    source_reader_close(&as_reader);
+
+    return am_buffer;
+}
+
+/*
+ * Function: pre_assembly
+ * -----------------------
+ * Performs preprocessing on the assembly file, expanding macros into an in-memory buffer.
+ *
+ * Parameters:
+ *   file_name: The name of the assembly file.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   keep_am_flag: When different from 0, the expanded source is also written to a .am file (debug aid).
+ *
+ * Returns:
+ *   A pointer to a dynamically allocated buffer containing the macro-expanded source,
+ *   or NULL if an error occurred. The caller is responsible for freeing the buffer.
+ */
+
+char *pre_assembly(char *file_name, HASH_TABLE *macro_table, int keep_am_flag)
+{
+    return pre_assembly_expand(file_name, macro_table, keep_am_flag, NULL);
+}
+
+/*
+ * Function: pre_assembly_streamed
+ * --------------------------------
+ * Performs preprocessing on the assembly file, pushing every expanded line into the
+ * given ring while building the in-memory buffer, so the parsing thread of the
+ * --pipeline mode consumes the lines while they are produced.
+ *
+ * Parameters:
+ *   file_name: The name of the assembly file.
+ *   macro_table: The open-addressing hash table containing macro definitions.
+ *   keep_am_flag: When different from 0, the expanded source is also written to a .am file (debug aid).
+ *   sink: The ring receiving the expanded lines.
+ *
+ * Returns:
+ *   A pointer to a dynamically allocated buffer containing the macro-expanded source,
+ *   or NULL if an error occurred. The caller is responsible for freeing the buffer.
+ */
+
+char *pre_assembly_streamed(char *file_name, HASH_TABLE *macro_table, int keep_am_flag, PIPELINE_RING *sink)
+{
+    return pre_assembly_expand(file_name, macro_table, keep_am_flag, sink);
 }
 
 /*
  * Function: free_macro_content
  * -----------------------------
- * Frees the memory allocated for a macro's content (lines of text).
+ * Frees the body buffer of a macro with a single call.
  *
  * Parameters:
- *   content: The content of the macro to free.
- *
- * Algorithm:
- *   1. Traverse the linked list of TEXT nodes.
- *   2. Free memory allocated for each TEXT node.
+ *   macro: The macro whose content should be freed.
  */
 
-void free_macro_content(TEXT *content)
+void free_macro_content(MACRO *macro)
 {
-    TEXT *current = content;
-    TEXT *temp;
-    while (current != NULL)
-    {
-        temp = current;
-        current = current->next;
-        free(temp->text);
-        free(temp);
-    }
+    free(macro->content);
+    macro->content = NULL;
+    macro->content_length = 0;
+    macro->content_capacity = 0;
 }
 
 /*
@@ -573,30 +777,125 @@ void free_macro_content(TEXT *content)
  * Frees the memory allocated for the macro hash table and its contents.
  *
  * Parameters:
- *   macro_table: The hash table containing macro definitions.
+ *   macro_table: The open-addressing hash table containing macro definitions.
  *
  * Algorithm:
- *   1. Traverse each slot of the hash table.
- *   2. Free memory allocated for each MACRO node and its content.
+ *   1. The MACRO nodes themselves are owned by the per-file arena, but their body buffers
+ *      grow with realloc, so each body is freed before the slot array of the table.
  */
 
-void free_macro_table(MACRO *macro_table[HASH_TABLE_SIZE])
+void free_macro_table(HASH_TABLE *macro_table)
 {
-    MACRO *current;
-    MACRO *temp;
     int i;
 
-    for (i = 0; i < HASH_TABLE_SIZE; i++)
+    for (i = 0; i < macro_table->capacity; i++)
     {
-        current = macro_table[i];
-        while (current != NULL)
+        if (macro_table->slots[i].name != NULL)
         {
-            temp = current;
-            current = current->next;
-            free_macro_content(temp->content);
-            free(temp->name);
-            free(temp);
+            free_macro_content((MACRO *)macro_table->slots[i].node);
+        }
+    }
+
+    free_hash_table(macro_table);
+}
+
+/*
+ * Function: macro_library_load
+ * -----------------------------
+ * Loads the shared macro library given with --macro-lib into its own table, using the
+ * same definition parsing as the pre-assembler. The library is parsed once per run,
+ * before any file is assembled; afterwards macro_lookup falls back to it whenever a
+ * name misses the per-file table, so the shared prelude is never re-parsed per file.
+ * Lines of the library that are not part of a macro definition carry no meaning there
+ * and are ignored.
+ *
+ * Parameters:
+ *   lib_file_name: Path of the macro library file.
+ *
+ * Returns:
+ *   NO_ERRORS if the library was loaded, SYNTAX_OR_LOGIC_ERROR if the file cannot be
+ *   opened or a definition is malformed and MEMORY_ALLOCATION_ERROR if memory
+ *   allocation fails.
+ */
+
+int macro_library_load(char *lib_file_name)
+{
+    SOURCE_READER lib_reader;
+    char line[MAX_LINE_LEN] = {0};
+    MACRO *mcr_ptr = NULL;
+    int line_num = 1;
+    int mcr_def_flag = 0;
+
+    if (source_reader_open(&lib_reader, lib_file_name) != NO_ERRORS)
+    {
+        diag_error("Error in file : %s , cannot be opened\n", lib_file_name);
+        return SYNTAX_OR_LOGIC_ERROR;
+    }
+
+    while (source_reader_gets(&lib_reader, line, MAX_LINE_LEN) != NULL)
+    {
+        switch (line_identifier(line, &mcr_ptr, &library_table, &library_filter, lib_file_name, line_num))
+        {
+        case error: /*The line_identifier function print the error type*/
+            source_reader_close(&lib_reader);
+            return SYNTAX_OR_LOGIC_ERROR;
+
+        case macro_definition:
+            mcr_def_flag = 1;
+            break;
+
+        case end_macro_definition:
+            mcr_def_flag = 0;
+            break;
+
+        case any_other_line:
+
+            if (mcr_ptr != NULL)
+            {
+                if (text_insert(mcr_ptr, line, lib_file_name, line_num) == MEMORY_ALLOCATION_ERROR)
+                {
+                    source_reader_close(&lib_reader);
+                    return MEMORY_ALLOCATION_ERROR;
+                }
+            }
+
+            break;
+
+        default: /*Comments and macro calls carry no meaning in a library*/
+            break;
         }
-        macro_table[i] = NULL;
+
+        line_num++;
+    }
+
+    if (mcr_def_flag == 1)
+    {
+        diag_error("Error in file : %s , a macro is defined without closing, i.e. without end_mcr\n", lib_file_name);
+        source_reader_close(&lib_reader);
+        return SYNTAX_OR_LOGIC_ERROR;
+    }
+
+    source_reader_close(&lib_reader);
+
+    /*From here on the table is read by every worker at once, so the lookups must not
+      bump its unsynchronized profile counters*/
+    library_table.shared = 1;
+    library_loaded = 1;
+    return NO_ERRORS;
+}
+
+/*
+ * Function: macro_library_free
+ * -----------------------------
+ * Releases the table of the shared macro library at the end of the run (the MACRO nodes
+ * themselves are owned by the library arena of the caller).
+ */
+
+void macro_library_free(void)
+{
+    if (library_loaded)
+    {
+        free_macro_table(&library_table);
+        library_loaded = 0;
     }
 }
@@ -0,0 +1,134 @@
+/*
+ * File: profile.c
+ * ---------------
+ * Description:
+ *   This file implements the --profile mode. It collects per-file and aggregate wall
+ *   time for each stage of the assembler, counts of the allocations funneled through
+ *   get_word, dynamic_strcat and insert_symbol, probe statistics of the symbol and
+ *   macro table lookups, and the peak memory of the process. Everything is printed as
+ *   PROFILE key=value lines, so a dashboard can scrape the output without parsing the
+ *   human-readable diagnostics around it.
+ *
+ *   The totals are protected by a mutex because in the -j mode several workers record
+ *   files concurrently; the hooks cost nothing when profiling is disabled.
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "include/profile.h"
+
+int profile_enabled = 0;
+
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static long alloc_counters[profile_alloc_counters] = {0};
+static double total_stage_seconds[4] = {0.0, 0.0, 0.0, 0.0};
+static long total_symbol_lookups = 0;
+static long total_symbol_probes = 0;
+static long total_macro_lookups = 0;
+static long total_macro_probes = 0;
+static int total_files = 0;
+
+/*
+ * Function: profile_seconds_now
+ * ------------------------------
+ * Description:
+ *   Returns the current wall clock time in seconds, with microsecond resolution.
+ */
+
+double profile_seconds_now(void)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return (double)now.tv_sec + (double)now.tv_usec / 1000000.0;
+}
+
+/*
+ * Function: profile_count_alloc
+ * ------------------------------
+ * Description:
+ *   Counts one allocation at the given site.
+ * Parameters:
+ *   - site: One of the profile_alloc_* identifiers.
+ */
+
+void profile_count_alloc(int site)
+{
+    if (!profile_enabled)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&profile_lock);
+    alloc_counters[site]++;
+    pthread_mutex_unlock(&profile_lock);
+}
+
+/*
+ * Function: profile_record_file
+ * ------------------------------
+ * Description:
+ *   Prints the machine-readable per-file profile lines and accumulates the values into
+ *   the aggregate totals.
+ * Parameters:
+ *   - file_name: The name of the input file, without the .as extension.
+ *   - pre_seconds, first_seconds, second_seconds, back_seconds: Wall time of each stage.
+ *   - symbol_lookups, symbol_probes: Lookup statistics of the symbol table of the file.
+ *   - macro_lookups, macro_probes: Lookup statistics of the macro table of the file.
+ */
+
+void profile_record_file(char *file_name, double pre_seconds, double first_seconds,
+                         double second_seconds, double back_seconds,
+                         long symbol_lookups, long symbol_probes,
+                         long macro_lookups, long macro_probes)
+{
+    pthread_mutex_lock(&profile_lock);
+
+    /*One line per file, printed with a single call so the -j workers do not tear it*/
+    printf("PROFILE file=%s pre_assembly=%.6f first_pass=%.6f second_pass=%.6f back_end=%.6f symbol_lookups=%ld symbol_probes=%ld macro_lookups=%ld macro_probes=%ld\n",
+           file_name, pre_seconds, first_seconds, second_seconds, back_seconds,
+           symbol_lookups, symbol_probes, macro_lookups, macro_probes);
+
+    total_stage_seconds[0] += pre_seconds;
+    total_stage_seconds[1] += first_seconds;
+    total_stage_seconds[2] += second_seconds;
+    total_stage_seconds[3] += back_seconds;
+    total_symbol_lookups += symbol_lookups;
+    total_symbol_probes += symbol_probes;
+    total_macro_lookups += macro_lookups;
+    total_macro_probes += macro_probes;
+    total_files++;
+
+    pthread_mutex_unlock(&profile_lock);
+}
+
+/*
+ * Function: profile_report
+ * -------------------------
+ * Description:
+ *   Prints the machine-readable aggregate summary, including the peak memory of the
+ *   process as reported by getrusage.
+ */
+
+void profile_report(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("PROFILE total files=%d pre_assembly=%.6f first_pass=%.6f second_pass=%.6f back_end=%.6f\n",
+           total_files, total_stage_seconds[0], total_stage_seconds[1],
+           total_stage_seconds[2], total_stage_seconds[3]);
+    printf("PROFILE total get_word_allocs=%ld dynamic_strcat_allocs=%ld insert_symbol_allocs=%ld\n",
+           alloc_counters[profile_alloc_get_word],
+           alloc_counters[profile_alloc_dynamic_strcat],
+           alloc_counters[profile_alloc_insert_symbol]);
+    printf("PROFILE total symbol_lookups=%ld symbol_probes=%ld macro_lookups=%ld macro_probes=%ld\n",
+           total_symbol_lookups, total_symbol_probes,
+           total_macro_lookups, total_macro_probes);
+    printf("PROFILE total peak_memory_kb=%ld\n", usage.ru_maxrss);
+}
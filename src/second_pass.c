@@ -3,451 +3,654 @@
 #include <stdio.h>
 
 #include "include/second_pass.h"
+#include "include/arena.h"
+#include "include/diag.h"
 
 /*
- * Function: ext_search
- * ---------------------
+ * Function: add_ext_address
+ * --------------------------
  * Description:
- *   This function searches for a given symbol name in the external symbol list.
+ *   This function records a reference to an external symbol by appending it to the
+ *   contiguous reference vector of the translation unit. The references are recorded
+ *   while the machine code is encoded, in increasing address order, so the vector is
+ *   sorted by address by construction and the externals file is emitted by one sweep
+ *   over it, without grouping or re-sorting.
  *
  * Parameters:
- *   - ext_list: Pointer to the head of the external symbol list.
- *   - symbol_name: Name of the symbol to search for.
+ *   - curr_program: Pointer to the translation unit holding the reference vector.
+ *   - symbol_name: Name of the symbol.
+ *   - symbol_address: Address of the reference in the machine code.
  *
  * Returns:
- *   - Pointer to the symbol if found, otherwise NULL.
+ *   - NO_ERROS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
  *
  * Algorithm:
- *   1. Initialize a pointer (sym_ptr) to the head of the external symbol list.
- *   2. Iterate through the external symbol list using a while loop until sym_ptr reaches the end (NULL).
- *   3. Within each iteration, check if the name of the current symbol (sym_ptr->ext_name) matches the provided symbol_name using strcmp.
- *   4. If a match is found, return the pointer to the current symbol (sym_ptr).
- *   5. If no match is found after iterating through the entire list, return NULL to indicate that the symbol was not found.
+ *   1. Double the reference vector when it is full.
+ *   2. Append the interned symbol name and the address of the reference.
  */
 
-EXT_SYMBOL *ext_search(EXT_SYMBOL *ext_list, char *symbol_name)
+int add_ext_address(TRANSLATION_UNIT *curr_program, char *symbol_name, int symbol_address)
 {
+    EXT_REF *temp;
 
-    EXT_SYMBOL *sym_ptr = ext_list;
-
-    while (sym_ptr != NULL)
+    if (curr_program->external_counter == curr_program->ext_refs_capacity)
     {
-        if (strcmp(sym_ptr->ext_name, symbol_name) == 0)
+        curr_program->ext_refs_capacity = (curr_program->ext_refs_capacity == 0) ? EXT_REFS_INITIAL_CAPACITY : curr_program->ext_refs_capacity * 2;
+        temp = (EXT_REF *)realloc(curr_program->ext_refs, curr_program->ext_refs_capacity * sizeof(EXT_REF));
+
+        if (temp == NULL)
         {
-            return sym_ptr;
+            return MEMORY_ALLOCATION_ERROR;
         }
 
-        sym_ptr = sym_ptr->next_ext;
+        curr_program->ext_refs = temp;
     }
 
-    return sym_ptr;
+    curr_program->ext_refs[curr_program->external_counter].ext_name = symbol_name; /*Interned, shared with the symbol table*/
+    curr_program->ext_refs[curr_program->external_counter].address = symbol_address;
+    curr_program->external_counter++;
+    return NO_ERRORS;
 }
 
 /*
- * Function: add_ext_address
- * --------------------------
+ * Function: fixup_append
+ * -----------------------
  * Description:
- *   This function adds an external address to the external symbol list or updates an existing symbol with a new address.
+ *   Appends one fixup to the fixup list of the single-pass mode, doubling the vector
+ *   when it is full.
  *
  * Parameters:
- *   - ext_list: Pointer to the pointer to the head of the external symbol list.
- *   - symbol_name: Name of the symbol.
- *   - symbol_address: Address of the symbol.
+ *   - fixups: The fixup list to append to.
+ *   - kind: The kind of the fixup (label word, instruction constant or data constant).
+ *   - word_index: Index of the word to patch in its memory image.
+ *   - name: Interned name of the symbol the word refers to.
+ *   - line_num: Line of the reference, for error messages and the defined-before check.
  *
  * Returns:
- *   - NO_ERROS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
- *
- * Algorithm:
- *   1. Allocate memory for a new external address structure.
- *   2. Check if memory allocation was successful. If not, return MEMORY_ALLOCATION_ERROR.
- *   3. Initialize the new external address with the provided symbol address.
- *   4. Search for the symbol in the external symbol list.
- *   5. If the symbol exists in the list:
- *      - Update the new address's next pointer to point to the existing symbol's address list.
- *      - Update the existing symbol's address list to point to the new address.
- *      - Return NO_ERRORS to indicate success.
- *   6. If the symbol does not exist in the list:
- *      - Allocate memory for a new external symbol structure.
- *      - Check if memory allocation was successful. If not, free the allocated address memory and return MEMORY_ALLOCATION_ERROR.
- *      - Initialize the new external symbol with the provided symbol name and the newly allocated address.
- *      - Update the new symbol's next pointer to point to the current head of the external symbol list.
- *      - Update the external symbol list pointer to point to the new symbol.
- *      - Return NO_ERRORS to indicate success.
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
  */
 
-int add_ext_address(EXT_SYMBOL **ext_list, char *symbol_name, int symbol_address)
+static int fixup_append(FIXUP_LIST *fixups, int kind, int word_index, char *name, int line_num)
 {
-    EXT_SYMBOL *ext_find;
-    EXT_SYMBOL *new_ext;
-    EXT_ADDRESS *new_address;
-
-    new_address = (EXT_ADDRESS *)malloc(sizeof(EXT_ADDRESS));
-
-    if (new_address == NULL)
-    {
-        return MEMORY_ALLOCATION_ERROR;
-    }
-
-    new_address->num = symbol_address;
-    new_address->next_address = NULL;
+    FIXUP *temp;
 
-    ext_find = ext_search(*ext_list, symbol_name);
-    if (ext_find)
+    if (fixups->count == fixups->capacity)
     {
-        new_address->next_address = ext_find->address;
-        ext_find->address = new_address;
-        return NO_ERRORS;
-    }
+        fixups->capacity = (fixups->capacity == 0) ? FIXUP_LIST_INITIAL_CAPACITY : fixups->capacity * 2;
+        temp = (FIXUP *)realloc(fixups->fixups, fixups->capacity * sizeof(FIXUP));
 
-    else /*The ext symbol is not exist in the external symbol list*/
-    {
-        new_ext = (EXT_SYMBOL *)malloc(sizeof(EXT_SYMBOL));
-        if (new_ext == NULL)
+        if (temp == NULL)
         {
-            free(new_address);
             return MEMORY_ALLOCATION_ERROR;
         }
 
-        new_ext->address = new_address;
-        strcpy(new_ext->ext_name, symbol_name);
-        new_ext->next_ext = *ext_list;
-        *ext_list = new_ext;
-        return NO_ERRORS;
+        fixups->fixups = temp;
     }
+
+    fixups->fixups[fixups->count].kind = kind;
+    fixups->fixups[fixups->count].word_index = word_index;
+    fixups->fixups[fixups->count].name = name;
+    fixups->fixups[fixups->count].line_num = line_num;
+    fixups->count++;
+    return NO_ERRORS;
 }
 
 /*
- * Function: second_pass
+ * Function: encode_line
  * ----------------------
  * Description:
- * Creates the binary coding for each line of instructions or directive (if the directive is data or string) and stores it in the array of instructions/data.
- * Creates a list of all external symbols.
+ *   Encodes one parsed instruction or directive line into the memory images of the
+ *   translation unit. When fixups is NULL, label and constant operands are resolved
+ *   from the symbol table immediately (the two-pass mode); when it is not NULL, they
+ *   are recorded as fixups and their words are left zero, so the line can be encoded
+ *   before the whole symbol table exists (the single-pass mode).
  *
  * Parameters:
- *   - curr_program: Pointer to the translation unit hat contains all the information about the file (symbol table, instruction array and ect...).
- *   - am_file_name: Name of the assembly file being processed.
- *   - am_file: Pointer to the file containing the assembly code.
+ *   - curr_program: Pointer to the translation unit receiving the encoded words.
+ *   - line_ast: The parsed line to encode.
+ *   - line_num: The number of the line in the am source (used in error messages).
+ *   - am_file_name: Name of the assembly file being processed (used in error messages).
+ *   - fixups: The fixup list of the single-pass mode, or NULL to resolve operands inline.
+ *   - err_flag: Set to SYNTAX_OR_LOGIC_ERROR when an operand cannot be resolved.
  *
  * Returns:
- *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails, SYNTAX_OR_LOGIC_ERROR if there are logical errors.
- *
- * Algorithm:
- *   1. Initialize variables including error flags, line number, and addressing method.
- *   2. Read each line from the assembly file.
- *   3. Create an Abstract Syntax Tree (AST) from the text of the line.
- *   5. Process each line based on its type (instruction or directive).
- *   6. Generate machine code for instructions or directives line and store it in the translation unit.
- *   7. Handle errors related to undefined symbols or constants.
- *   8. Continue processing until the end of the file.
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails.
  */
 
-int second_pass(TRANSLATION_UNIT *curr_program, char *am_file_name, FILE *am_file)
+int encode_line(TRANSLATION_UNIT *curr_program, LINE_AST *line_ast, int line_num, char *am_file_name, FIXUP_LIST *fixups, int *err_flag)
 {
-    int err_flag = NO_ERRORS;
-    int line_num = 1;
     int i;
+    int str_length;
     short addressing_method;
-    char line[MAX_LINE_LEN];
-    LINE_AST line_ast = {0};
     SYMBOL *sym_find;
     int ext_add_result;
 
-    while (fgets(line, MAX_LINE_LEN, am_file))
+    if (line_ast->type == inst)
     {
-
-        line_ast = create_ast_from_text(line);
-
-        if (strcmp(line_ast.error_detail, "memory allocation failed") == 0)
+        /*An instruction encodes at most five words: the first word and up to two words
+          per operand, so the room for the whole line is reserved up front*/
+        if (memory_image_reserve(&curr_program->instruction_image, curr_program->ic + 5) == MEMORY_ALLOCATION_ERROR)
         {
+            diag_error("Error in: %s , memory allocation failed \n", am_file_name);
             return MEMORY_ALLOCATION_ERROR;
         }
 
-        if (line_ast.type == inst)
-        {
-            /*create the binary code of the first memory word - according to th logic of the project*/
+        /*create the binary code of the first memory word - according to th logic of the project*/
 
-            for (i = 0; i < MAX_INST_OPERANDS; i++)
+        for (i = 0; i < MAX_INST_OPERANDS; i++)
+        {
+            if (line_ast->operand.instruction.operands[i].type == number || line_ast->operand.instruction.operands[i].type == constant || line_ast->operand.instruction.operands[i].type == none)
             {
-                if (line_ast.operand.instruction.operands[i].type == number || line_ast.operand.instruction.operands[i].type == constant || line_ast.operand.instruction.operands[i].type == none)
-                {
-                    addressing_method = 0;
-                }
+                addressing_method = 0;
+            }
 
-                else if (line_ast.operand.instruction.operands[i].type == label)
-                {
-                    addressing_method = 1;
-                }
+            else if (line_ast->operand.instruction.operands[i].type == label)
+            {
+                addressing_method = 1;
+            }
 
-                else if (line_ast.operand.instruction.operands[i].type == label_with_index)
-                {
-                    addressing_method = 2;
-                }
+            else if (line_ast->operand.instruction.operands[i].type == label_with_index)
+            {
+                addressing_method = 2;
+            }
 
-                else /*The operand type is register*/
-                {
-                    addressing_method = 3;
-                }
+            else /*The operand type is register*/
+            {
+                addressing_method = 3;
+            }
 
-                if (i == DESTINATION_OPERAND)
-                {
-                    curr_program->instruction_array[curr_program->ic] |= addressing_method << 2;
-                }
+            if (i == DESTINATION_OPERAND)
+            {
+                memory_image_or(&curr_program->instruction_image, curr_program->ic, addressing_method << 2);
+            }
 
-                else
-                {
-                    curr_program->instruction_array[curr_program->ic] |= addressing_method << 4;
-                }
+            else
+            {
+                memory_image_or(&curr_program->instruction_image, curr_program->ic, addressing_method << 4);
             }
+        }
 
-            curr_program->instruction_array[curr_program->ic] |= line_ast.operand.instruction.type << 6;
-            curr_program->ic++;
+        memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.type << 6);
+        curr_program->ic++;
 
-            /*Identifying whether additional memory words need to be created and if so creating them*/
+        /*Identifying whether additional memory words need to be created and if so creating them*/
 
-            /*If the operand are register, add one memory word*/
-            if ((line_ast.operand.instruction.operands[SOURCE_OPERAND].type == reg) && (line_ast.operand.instruction.operands[DESTINATION_OPERAND].type == reg))
-            {
-                curr_program->instruction_array[curr_program->ic] |= line_ast.operand.instruction.operands[DESTINATION_OPERAND].num << 2;
-                curr_program->instruction_array[curr_program->ic] |= line_ast.operand.instruction.operands[SOURCE_OPERAND].num << 5;
-                curr_program->ic++;
-            }
+        /*If the operand are register, add one memory word*/
+        if ((line_ast->operand.instruction.operands[SOURCE_OPERAND].type == reg) && (line_ast->operand.instruction.operands[DESTINATION_OPERAND].type == reg))
+        {
+            memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.operands[DESTINATION_OPERAND].num << 2);
+            memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.operands[SOURCE_OPERAND].num << 5);
+            curr_program->ic++;
+        }
 
-            else /*at least one of the operands is not register*/
+        else /*at least one of the operands is not register*/
+        {
+            for (i = 0; i < MAX_INST_OPERANDS; i++)
             {
-                for (i = 0; i < MAX_INST_OPERANDS; i++)
+                if (line_ast->operand.instruction.operands[i].type == number)
                 {
-                    if (line_ast.operand.instruction.operands[i].type == number)
+
+                    memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.operands[i].num << 2);
+                    curr_program->ic++;
+                }
+
+                else if (line_ast->operand.instruction.operands[i].type == constant)
+                {
+                    /*In the single-pass mode the constant may not be defined yet, so the word
+                      is left zero and patched by resolve_fixups after the whole file was read*/
+                    if (fixups != NULL)
                     {
+                        if (fixup_append(fixups, fixup_inst_constant, curr_program->ic, line_ast->operand.instruction.operands[i].constant_name, line_num) == MEMORY_ALLOCATION_ERROR)
+                        {
+                            diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                            return MEMORY_ALLOCATION_ERROR;
+                        }
 
-                        curr_program->instruction_array[curr_program->ic] |= line_ast.operand.instruction.operands[i].num << 2;
                         curr_program->ic++;
+                        continue;
                     }
 
-                    else if (line_ast.operand.instruction.operands[i].type == constant)
-                    {
-                        /*Checking whether the constant was defined in the file, and if so checking whether it was defined in the line before this line*/
-                        sym_find = symbol_lookup(line_ast.operand.instruction.operands[i].constant_name, curr_program->symbol_table);
+                    /*Checking whether the constant was defined in the file, and if so checking whether it was defined in the line before this line*/
+                    sym_find = symbol_lookup(line_ast->operand.instruction.operands[i].constant_name, &curr_program->symbol_table);
 
-                        if (sym_find)
+                    if (sym_find)
+                    {
+                        /*The symbol was define on a line before the current line*/
+                        if (sym_find->address < line_num)
                         {
-                            /*The symbol was define on a line before the current line*/
-                            if (sym_find->address < line_num)
-                            {
-                                curr_program->instruction_array[curr_program->ic] |= sym_find->value << 2;
-                                curr_program->ic++;
-                            }
-
-                            else /*The symbol was define on a line after the current line*/
-                            {
-                                printf("Error in: %s , in line number: %d , using a constant whose definition is done at a later stage in the file\n", am_file_name, line_num);
-                                err_flag = SYNTAX_OR_LOGIC_ERROR;
-                                continue;
-                            }
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, sym_find->value << 2);
+                            curr_program->ic++;
                         }
 
-                        else /*The constant was not defined in the file*/
+                        else /*The symbol was define on a line after the current line*/
                         {
-                            printf("Error in: %s , in line number: %d , using a constant that was not defined in the file\n", am_file_name, line_num);
-                            err_flag = SYNTAX_OR_LOGIC_ERROR;
+                            diag_error("Error in: %s , in line number: %d , using a constant whose definition is done at a later stage in the file\n", am_file_name, line_num);
+                            *err_flag = SYNTAX_OR_LOGIC_ERROR;
                             continue;
                         }
                     }
 
-                    else if (line_ast.operand.instruction.operands[i].type == reg)
+                    else /*The constant was not defined in the file*/
+                    {
+                        diag_error("Error in: %s , in line number: %d , using a constant that was not defined in the file\n", am_file_name, line_num);
+                        *err_flag = SYNTAX_OR_LOGIC_ERROR;
+                        continue;
+                    }
+                }
+
+                else if (line_ast->operand.instruction.operands[i].type == reg)
+                {
+                    if (i == SOURCE_OPERAND)
+                    {
+                        memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.operands[SOURCE_OPERAND].num << 5);
+                    }
+
+                    else /*Its is a destnation operand */
+                    {
+                        memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.operands[DESTINATION_OPERAND].num << 2);
+                    }
+
+                    curr_program->ic++;
+                }
+
+                else if (line_ast->operand.instruction.operands[i].type == label)
+                {
+                    /*In the single-pass mode the label may be a forward reference, so the word
+                      is left zero and patched by resolve_fixups after the whole file was read*/
+                    if (fixups != NULL)
                     {
-                        if (i == SOURCE_OPERAND)
+                        if (fixup_append(fixups, fixup_inst_label, curr_program->ic, line_ast->operand.instruction.operands[i].label, line_num) == MEMORY_ALLOCATION_ERROR)
                         {
-                            curr_program->instruction_array[curr_program->ic] |= line_ast.operand.instruction.operands[SOURCE_OPERAND].num << 5;
+                            diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                            return MEMORY_ALLOCATION_ERROR;
                         }
 
-                        else /*Its is a destnation operand */
+                        curr_program->ic++;
+                        continue;
+                    }
+
+                    /*Checking whether the label was defined in the file*/
+                    sym_find = symbol_lookup(line_ast->operand.instruction.operands[i].label, &curr_program->symbol_table);
+
+                    if (sym_find)
+                    {
+
+                        if (sym_find->type == extern_sym)
+                        {
+                            /*The 0-1 bits are 01, the other 12 bits are 0*/
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, 1);
+                            /*add_ext_adress */
+                            ext_add_result = add_ext_address(curr_program, sym_find->name, curr_program->ic);
+                            if (ext_add_result == MEMORY_ALLOCATION_ERROR)
+                            {
+                                diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                                return MEMORY_ALLOCATION_ERROR;
+                            }
+                        }
+
+                        else
                         {
-                            curr_program->instruction_array[curr_program->ic] |= line_ast.operand.instruction.operands[DESTINATION_OPERAND].num << 2;
+                            /*The 0-1 bits are 10, the other 12 bits are the binary code of the adrress of the symbol as unsinged number*/
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, 2);
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, sym_find->address << 2);
                         }
 
                         curr_program->ic++;
                     }
 
-                    else if (line_ast.operand.instruction.operands[i].type == label)
+                    else /*The label was not defined in the file*/
                     {
-                        /*Checking whether the label was defined in the file*/
-                        sym_find = symbol_lookup(line_ast.operand.instruction.operands[i].label, curr_program->symbol_table);
+                        diag_error("Error in: %s , in line number: %d , using a label that was not defined in the file\n", am_file_name, line_num);
+                        *err_flag = SYNTAX_OR_LOGIC_ERROR;
+                        continue;
+                    }
+                }
 
-                        if (sym_find)
+                else if (line_ast->operand.instruction.operands[i].type == label_with_index)
+                {
+                    /*In the single-pass mode both words are emitted now: the label word is
+                      always a fixup and the index word is a fixup when it names a constant*/
+                    if (fixups != NULL)
+                    {
+                        if (fixup_append(fixups, fixup_inst_label, curr_program->ic, line_ast->operand.instruction.operands[i].label, line_num) == MEMORY_ALLOCATION_ERROR)
                         {
+                            diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                            return MEMORY_ALLOCATION_ERROR;
+                        }
 
-                            if (sym_find->type == extern_sym)
-                            {
-                                /*The 0-1 bits are 01, the other 12 bits are 0*/
-                                curr_program->instruction_array[curr_program->ic] |= 1;
-                                /*add_ext_adress */
-                                curr_program->external_counter++;
-                                ext_add_result = add_ext_address(&curr_program->ext_list, sym_find->name, curr_program->ic);
-                                if (ext_add_result == MEMORY_ALLOCATION_ERROR)
-                                {
-                                    printf("Error in: %s , memory allocation failed \n", am_file_name);
-                                    return MEMORY_ALLOCATION_ERROR;
-                                }
-                            }
+                        curr_program->ic++;
 
-                            else
+                        if (line_ast->operand.instruction.operands[i].constant_name != NULL)
+                        {
+                            if (fixup_append(fixups, fixup_inst_constant, curr_program->ic, line_ast->operand.instruction.operands[i].constant_name, line_num) == MEMORY_ALLOCATION_ERROR)
                             {
-                                /*The 0-1 bits are 10, the other 12 bits are the binary code of the adrress of the symbol as unsinged number*/
-                                curr_program->instruction_array[curr_program->ic] |= 2;
-                                curr_program->instruction_array[curr_program->ic] |= sym_find->address << 2;
+                                diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                                return MEMORY_ALLOCATION_ERROR;
                             }
-
-                            curr_program->ic++;
                         }
 
-                        else /*The label was not defined in the file*/
+                        else /*the index is a number*/
                         {
-                            printf("Error in: %s , in line number: %d , using a label that was not defined in the file\n", am_file_name, line_num);
-                            err_flag = SYNTAX_OR_LOGIC_ERROR;
-                            continue;
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.operands[i].num << 2);
                         }
+
+                        curr_program->ic++;
+                        continue;
                     }
 
-                    else if (line_ast.operand.instruction.operands[i].type == label_with_index)
+                    /*Checking whether the label was defined in the file*/
+                    sym_find = symbol_lookup(line_ast->operand.instruction.operands[i].label, &curr_program->symbol_table);
+
+                    if (sym_find)
                     {
-                        /*Checking whether the label was defined in the file*/
-                        sym_find = symbol_lookup(line_ast.operand.instruction.operands[i].label, curr_program->symbol_table);
 
-                        if (sym_find)
+                        if (sym_find->type == extern_sym)
                         {
-
-                            if (sym_find->type == extern_sym)
+                            /*The 0-1 bits are 01, the other 12 bits are 0*/
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, 1);
+                            /*add_ext_adress */
+                            ext_add_result = add_ext_address(curr_program, sym_find->name, curr_program->ic);
+                            if (ext_add_result == MEMORY_ALLOCATION_ERROR)
                             {
-                                /*The 0-1 bits are 01, the other 12 bits are 0*/
-                                curr_program->instruction_array[curr_program->ic] |= 1;
-                                /*add_ext_adress */
-                                curr_program->external_counter++;
-                                ext_add_result = add_ext_address(&curr_program->ext_list, sym_find->name, curr_program->ic);
-                                if (ext_add_result == MEMORY_ALLOCATION_ERROR)
-                                {
-                                    printf("Error in: %s , memory allocation failed\n", am_file_name);
-                                    return MEMORY_ALLOCATION_ERROR;
-                                }
+                                diag_error("Error in: %s , memory allocation failed\n", am_file_name);
+                                return MEMORY_ALLOCATION_ERROR;
                             }
+                        }
 
-                            else
-                            {
-                                /*The 0-1 bits are 10, the other 12 bits are the binary code of the adrress of the symbol as unsinged number*/
-                                curr_program->instruction_array[curr_program->ic] |= 2;
-                                curr_program->instruction_array[curr_program->ic] |= sym_find->address << 2;
-                            }
+                        else
+                        {
+                            /*The 0-1 bits are 10, the other 12 bits are the binary code of the adrress of the symbol as unsinged number*/
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, 2);
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, sym_find->address << 2);
+                        }
 
-                            curr_program->ic++;
+                        curr_program->ic++;
 
-                            /*Check whether the index is constant*/
-                            if (line_ast.operand.instruction.operands[i].constant_name[0] != '\0')
-                            {
-                                sym_find = symbol_lookup(line_ast.operand.instruction.operands[i].constant_name, curr_program->symbol_table);
+                        /*Check whether the index is constant*/
+                        if (line_ast->operand.instruction.operands[i].constant_name != NULL)
+                        {
+                            sym_find = symbol_lookup(line_ast->operand.instruction.operands[i].constant_name, &curr_program->symbol_table);
 
-                                if (sym_find)
+                            if (sym_find)
+                            {
+                                /*The constant was define on a line before the current line*/
+                                if (sym_find->address < line_num)
                                 {
-                                    /*The constant was define on a line before the current line*/
-                                    if (sym_find->address < line_num)
-                                    {
-                                        /*The 0-1 bits are 0, the other 12 bits are the binary code of the number That the constant represent*/
-                                        curr_program->instruction_array[curr_program->ic] |= sym_find->value << 2;
-                                    }
-
-                                    else /*The constant was define on a line after the current line*/
-                                    {
-                                        printf("Error in: %s , in line number: %d , using a constant whose definition is done at a later stage in the file\n", am_file_name, line_num);
-                                        err_flag = SYNTAX_OR_LOGIC_ERROR;
-                                        continue;
-                                    }
+                                    /*The 0-1 bits are 0, the other 12 bits are the binary code of the number That the constant represent*/
+                                    memory_image_or(&curr_program->instruction_image, curr_program->ic, sym_find->value << 2);
                                 }
 
-                                else /*The constant was not defined in the file*/
+                                else /*The constant was define on a line after the current line*/
                                 {
-                                    printf("Error in: %s , in line number: %d , using a constant that was not defined in the file\n", am_file_name, line_num);
-                                    err_flag = SYNTAX_OR_LOGIC_ERROR;
+                                    diag_error("Error in: %s , in line number: %d , using a constant whose definition is done at a later stage in the file\n", am_file_name, line_num);
+                                    *err_flag = SYNTAX_OR_LOGIC_ERROR;
                                     continue;
                                 }
                             }
 
-                            else /*the index is a number*/
+                            else /*The constant was not defined in the file*/
                             {
-                                /*the 0-1 bits are 0 and the others are the binary code of the num*/
-                                curr_program->instruction_array[curr_program->ic] |= line_ast.operand.instruction.operands[i].num << 2;
+                                diag_error("Error in: %s , in line number: %d , using a constant that was not defined in the file\n", am_file_name, line_num);
+                                *err_flag = SYNTAX_OR_LOGIC_ERROR;
+                                continue;
                             }
-
-                            curr_program->ic++;
                         }
 
-                        else /*The label was not defined in the file*/
+                        else /*the index is a number*/
                         {
-                            printf("Error in: %s , in line number: %d , using a label that was not defined in the file\n", am_file_name, line_num);
-                            err_flag = SYNTAX_OR_LOGIC_ERROR;
-                            continue;
+                            /*the 0-1 bits are 0 and the others are the binary code of the num*/
+                            memory_image_or(&curr_program->instruction_image, curr_program->ic, line_ast->operand.instruction.operands[i].num << 2);
                         }
+
+                        curr_program->ic++;
+                    }
+
+                    else /*The label was not defined in the file*/
+                    {
+                        diag_error("Error in: %s , in line number: %d , using a label that was not defined in the file\n", am_file_name, line_num);
+                        *err_flag = SYNTAX_OR_LOGIC_ERROR;
+                        continue;
                     }
                 }
             }
         }
+    }
 
-        else if (line_ast.type == dir)
+    else if (line_ast->type == dir)
+    {
+        if (line_ast->operand.directive.type == string)
         {
-            if (line_ast.operand.directive.type == string)
+            /*The front end accepts any string that fits the source line, so the reserve
+              must cover its real length (plus the terminator), not a fixed bound*/
+            str_length = 0;
+            while (line_ast->operand.directive.operands.str[str_length] != 0)
             {
-                i = 0;
-                while (line_ast.operand.directive.operands.str[i] != 0)
-                {
-                    /* add to the data image the asci code of the number using 14 bits */
-                    curr_program->data_array[curr_program->dc] |= line_ast.operand.directive.operands.str[i];
-                    curr_program->dc++;
-                    i++;
-                }
-                /*advancing the dc counter for the \0 char */
+                str_length++;
+            }
+
+            if (memory_image_reserve(&curr_program->data_image, curr_program->dc + str_length + 1) == MEMORY_ALLOCATION_ERROR)
+            {
+                diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                return MEMORY_ALLOCATION_ERROR;
+            }
+
+            i = 0;
+            while (line_ast->operand.directive.operands.str[i] != 0)
+            {
+                /* add to the data image the asci code of the number using 14 bits */
+                memory_image_or(&curr_program->data_image, curr_program->dc, line_ast->operand.directive.operands.str[i]);
                 curr_program->dc++;
+                i++;
+            }
+            /*advancing the dc counter for the \0 char */
+            curr_program->dc++;
+        }
+
+        else if (line_ast->operand.directive.type == data)
+        {
+            if (memory_image_reserve(&curr_program->data_image, curr_program->dc + line_ast->operand.directive.operand_counter) == MEMORY_ALLOCATION_ERROR)
+            {
+                diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                return MEMORY_ALLOCATION_ERROR;
             }
 
-            else if (line_ast.operand.directive.type == data)
+            for (i = 0; i < line_ast->operand.directive.operand_counter; i++)
             {
-                for (i = 0; i < line_ast.operand.directive.operand_counter; i++)
+                if (line_ast->operand.directive.operands.data[i].data_type == data_int)
                 {
-                    if (line_ast.operand.directive.operands.data[i].data_type == data_int)
+                    memory_image_or(&curr_program->data_image, curr_program->dc, line_ast->operand.directive.operands.data[i].data_value.num);
+                }
+
+                else /*the current operand in data is constant*/
+                {
+                    /*In the single-pass mode the constant may not be defined yet, so the word
+                      is left zero and patched by resolve_fixups after the whole file was read*/
+                    if (fixups != NULL)
                     {
-                        curr_program->data_array[curr_program->dc] |= line_ast.operand.directive.operands.data[i].data_value.num;
+                        if (fixup_append(fixups, fixup_data_constant, curr_program->dc, line_ast->operand.directive.operands.data[i].data_value.constant_name, line_num) == MEMORY_ALLOCATION_ERROR)
+                        {
+                            diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                            return MEMORY_ALLOCATION_ERROR;
+                        }
+
+                        curr_program->dc++;
+                        continue;
                     }
 
-                    else /*the current operand in data is constant*/
-                    {
-                        sym_find = symbol_lookup(line_ast.operand.directive.operands.data[i].data_value.constant_name, curr_program->symbol_table);
+                    sym_find = symbol_lookup(line_ast->operand.directive.operands.data[i].data_value.constant_name, &curr_program->symbol_table);
 
-                        if (sym_find)
+                    if (sym_find)
+                    {
+                        /*The symbol was define on a line before the current line*/
+                        if (sym_find->address < line_num)
                         {
-                            /*The symbol was define on a line before the current line*/
-                            if (sym_find->address < line_num)
-                            {
-                                /* add the asci code of the number that constant is represent */
-                                curr_program->data_array[curr_program->dc] |= sym_find->value;
-                            }
-
-                            else /*/*The symbol was define on a line after the current line*/
-                            {
-                                printf("Error in: %s , in line number: %d , using a constant whose definition is done at a later stage in the file\n", am_file_name, line_num);
-                                err_flag = SYNTAX_OR_LOGIC_ERROR;
-                                continue;
-                            }
+                            /* add the asci code of the number that constant is represent */
+                            memory_image_or(&curr_program->data_image, curr_program->dc, sym_find->value);
                         }
 
-                        else /*The constant was not defined in the file*/
+                        else /*/*The symbol was define on a line after the current line*/
                         {
-                            printf("Error in: %s , in line number: %d , using a constant that was not defined in the file\n", am_file_name, line_num);
-                            err_flag = SYNTAX_OR_LOGIC_ERROR;
+                            diag_error("Error in: %s , in line number: %d , using a constant whose definition is done at a later stage in the file\n", am_file_name, line_num);
+                            *err_flag = SYNTAX_OR_LOGIC_ERROR;
                             continue;
                         }
                     }
-                    curr_program->dc++;
+
+                    else /*The constant was not defined in the file*/
+                    {
+                        diag_error("Error in: %s , in line number: %d , using a constant that was not defined in the file\n", am_file_name, line_num);
+                        *err_flag = SYNTAX_OR_LOGIC_ERROR;
+                        continue;
+                    }
                 }
+                curr_program->dc++;
             }
         }
+    }
+
+    return NO_ERRORS;
+}
+
+/*
+ * Function: resolve_constant_operands
+ * ------------------------------------
+ * Description:
+ *   Folds the named constants of the parsed stream into plain numbers in one step
+ *   between the passes, so encoding reads an int directly instead of hashing the name
+ *   of every constant operand. A constant is folded only when its symbol exists and was
+ *   defined before the line that uses it; anything else is left as a name, so
+ *   encode_line reports the same diagnostics at the same point as before. Generated
+ *   data tables repeat a handful of constant names over thousands of operands, so the
+ *   last resolved name is memoized and repeated uses skip the table entirely (the names
+ *   are interned, so one pointer comparison identifies a repeat).
+ *
+ * Parameters:
+ *   - curr_program: Pointer to the translation unit holding the symbol table.
+ *   - ast_stream: The stream of parsed lines, rewritten in place.
+ */
+
+static void resolve_constant_operands(TRANSLATION_UNIT *curr_program, AST_STREAM *ast_stream)
+{
+    char *last_name = NULL;
+    SYMBOL *last_sym = NULL;
+    LINE_AST *line_ast;
+    int line_num;
+    int node_num;
+    int i;
+
+    for (node_num = 0; node_num < ast_stream->count; node_num++)
+    {
+        line_ast = &ast_stream->nodes[node_num].ast;
+        line_num = ast_stream->nodes[node_num].line_num;
+
+        if (line_ast->type == inst)
+        {
+            for (i = 0; i < MAX_INST_OPERANDS; i++)
+            {
+                if (line_ast->operand.instruction.operands[i].type == constant)
+                {
+                    if (line_ast->operand.instruction.operands[i].constant_name != last_name)
+                    {
+                        last_name = line_ast->operand.instruction.operands[i].constant_name;
+                        last_sym = symbol_lookup(last_name, &curr_program->symbol_table);
+                    }
+
+                    if (last_sym != NULL && last_sym->address < line_num)
+                    {
+                        /*number and constant share the immediate addressing method and
+                          the same cell count, so the rewrite changes nothing else*/
+                        line_ast->operand.instruction.operands[i].type = number;
+                        line_ast->operand.instruction.operands[i].num = last_sym->value;
+                    }
+                }
+
+                else if (line_ast->operand.instruction.operands[i].type == label_with_index &&
+                         line_ast->operand.instruction.operands[i].constant_name != NULL)
+                {
+                    if (line_ast->operand.instruction.operands[i].constant_name != last_name)
+                    {
+                        last_name = line_ast->operand.instruction.operands[i].constant_name;
+                        last_sym = symbol_lookup(last_name, &curr_program->symbol_table);
+                    }
+
+                    if (last_sym != NULL && last_sym->address < line_num)
+                    {
+                        line_ast->operand.instruction.operands[i].constant_name = NULL;
+                        line_ast->operand.instruction.operands[i].num = last_sym->value;
+                    }
+                }
+            }
+        }
+
+        else if (line_ast->type == dir && line_ast->operand.directive.type == data)
+        {
+            for (i = 0; i < line_ast->operand.directive.operand_counter; i++)
+            {
+                if (line_ast->operand.directive.operands.data[i].data_type == data_constant)
+                {
+                    if (line_ast->operand.directive.operands.data[i].data_value.constant_name != last_name)
+                    {
+                        last_name = line_ast->operand.directive.operands.data[i].data_value.constant_name;
+                        last_sym = symbol_lookup(last_name, &curr_program->symbol_table);
+                    }
+
+                    if (last_sym != NULL && last_sym->address < line_num)
+                    {
+                        line_ast->operand.directive.operands.data[i].data_type = data_int;
+                        line_ast->operand.directive.operands.data[i].data_value.num = last_sym->value;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Function: second_pass
+ * ----------------------
+ * Description:
+ * Creates the binary coding for each line of instructions or directive (if the directive is data or string) and stores it in the array of instructions/data.
+ * Creates a list of all external symbols.
+ *
+ * Parameters:
+ *   - curr_program: Pointer to the translation unit hat contains all the information about the file (symbol table, instruction array and ect...).
+ *   - am_file_name: Name of the assembly file being processed (used in error messages).
+ *   - ast_stream: The stream of parsed lines that the first pass collected.
+ *
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails, SYNTAX_OR_LOGIC_ERROR if there are logical errors.
+ *
+ * Algorithm:
+ *   1. Fold the resolvable named constants of the stream into plain numbers in one step.
+ *   2. Iterate over the ASTs that the first pass collected (the text is not parsed again).
+ *   3. Encode each instruction or directive line with encode_line; constants that could
+ *      not be folded are resolved there and produce the usual diagnostics.
+ *   4. Continue processing until the end of the stream.
+ */
+
+int second_pass(TRANSLATION_UNIT *curr_program, char *am_file_name, AST_STREAM *ast_stream)
+{
+    int err_flag = NO_ERRORS;
+    int node_num;
+
+    /*Fold every resolvable named constant into a plain number once, so the encoding
+      loop below reads ints directly*/
+    resolve_constant_operands(curr_program, ast_stream);
+
+    for (node_num = 0; node_num < ast_stream->count; node_num++)
+    {
+        /*With --quiet-after=N the error limit of the file was reached, so the rest of
+          the stream is not encoded; err_flag is already set*/
+        if (diag_limit_reached())
+        {
+            break;
+        }
 
-        line_num++;
+        if (encode_line(curr_program, &ast_stream->nodes[node_num].ast, ast_stream->nodes[node_num].line_num,
+                        am_file_name, NULL, &err_flag) == MEMORY_ALLOCATION_ERROR)
+        {
+            return MEMORY_ALLOCATION_ERROR;
+        }
     }
 
     if (err_flag == NO_ERRORS)
@@ -461,3 +664,116 @@ int second_pass(TRANSLATION_UNIT *curr_program, char *am_file_name, FILE *am_fil
     }
 }
 
+/*
+ * Function: resolve_fixups
+ * -------------------------
+ * Description:
+ *   Patches every word the single-pass mode left unresolved, now that the symbol table
+ *   is complete. The fixups are applied in encoding order, so the external references
+ *   are recorded in the same order the two-pass mode records them.
+ *
+ * Parameters:
+ *   - curr_program: Pointer to the translation unit holding the images and the symbol table.
+ *   - am_file_name: Name of the assembly file being processed (used in error messages).
+ *   - fixups: The fixups recorded while encoding, in encoding order.
+ *
+ * Returns:
+ *   - NO_ERRORS if successful, MEMORY_ALLOCATION_ERROR if memory allocation fails, SYNTAX_OR_LOGIC_ERROR if a fixup cannot be resolved.
+ *
+ * Algorithm:
+ *   1. Look up the symbol of each fixup in the completed symbol table.
+ *   2. Patch label words with the address of their symbol, or mark them external and
+ *      record the reference.
+ *   3. Patch constant words with the value of their constant, after checking that the
+ *      constant was defined before the line that uses it.
+ *   4. Report undefined and late-defined symbols with the same messages as the two-pass mode.
+ */
+
+int resolve_fixups(TRANSLATION_UNIT *curr_program, char *am_file_name, FIXUP_LIST *fixups)
+{
+    int err_flag = NO_ERRORS;
+    int i;
+    FIXUP *fix;
+    SYMBOL *sym_find;
+    char *last_name = NULL;
+    SYMBOL *last_sym = NULL;
+
+    for (i = 0; i < fixups->count; i++)
+    {
+        /*With --quiet-after=N the error limit of the file was reached*/
+        if (diag_limit_reached())
+        {
+            break;
+        }
+
+        fix = &fixups->fixups[i];
+
+        /*The names are interned, so one pointer comparison recognizes the previous name
+          and repeated uses of the same constant or label skip the table*/
+        if (fix->name != last_name)
+        {
+            last_name = fix->name;
+            last_sym = symbol_lookup(fix->name, &curr_program->symbol_table);
+        }
+
+        sym_find = last_sym;
+
+        if (fix->kind == fixup_inst_label)
+        {
+            if (sym_find == NULL) /*The label was not defined in the file*/
+            {
+                diag_error("Error in: %s , in line number: %d , using a label that was not defined in the file\n", am_file_name, fix->line_num);
+                err_flag = SYNTAX_OR_LOGIC_ERROR;
+                continue;
+            }
+
+            if (sym_find->type == extern_sym)
+            {
+                /*The 0-1 bits are 01, the other 12 bits are 0*/
+                memory_image_or(&curr_program->instruction_image, fix->word_index, 1);
+
+                if (add_ext_address(curr_program, sym_find->name, fix->word_index) == MEMORY_ALLOCATION_ERROR)
+                {
+                    diag_error("Error in: %s , memory allocation failed \n", am_file_name);
+                    return MEMORY_ALLOCATION_ERROR;
+                }
+            }
+
+            else
+            {
+                /*The 0-1 bits are 10, the other 12 bits are the binary code of the adrress of the symbol as unsinged number*/
+                memory_image_or(&curr_program->instruction_image, fix->word_index, 2);
+                memory_image_or(&curr_program->instruction_image, fix->word_index, sym_find->address << 2);
+            }
+        }
+
+        else /*The fixup is a constant word, in the instruction image or in the data image*/
+        {
+            if (sym_find == NULL) /*The constant was not defined in the file*/
+            {
+                diag_error("Error in: %s , in line number: %d , using a constant that was not defined in the file\n", am_file_name, fix->line_num);
+                err_flag = SYNTAX_OR_LOGIC_ERROR;
+                continue;
+            }
+
+            if (sym_find->address >= fix->line_num) /*The constant was define on a line after the current line*/
+            {
+                diag_error("Error in: %s , in line number: %d , using a constant whose definition is done at a later stage in the file\n", am_file_name, fix->line_num);
+                err_flag = SYNTAX_OR_LOGIC_ERROR;
+                continue;
+            }
+
+            if (fix->kind == fixup_inst_constant)
+            {
+                memory_image_or(&curr_program->instruction_image, fix->word_index, sym_find->value << 2);
+            }
+
+            else /*The fixup is a data word*/
+            {
+                memory_image_or(&curr_program->data_image, fix->word_index, sym_find->value);
+            }
+        }
+    }
+
+    return err_flag;
+}
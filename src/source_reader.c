@@ -0,0 +1,166 @@
+/*
+ * File: source_reader.c
+ * ---------------------
+ * Description:
+ *   This file implements a reader abstraction over the input source files. Regular files
+ *   are mapped into memory with mmap and scanned as pointer/length line spans, which is
+ *   measurably faster than per-line fgets calls for large generated sources. Inputs that
+ *   cannot be mapped (for example pipes) transparently fall back to the stdio path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "include/source_reader.h"
+
+/*
+ * Function: source_reader_open
+ * -----------------------------
+ * Description:
+ *   Opens a source file for line-by-line reading, preferring an mmap of the whole file.
+ * Parameters:
+ *   - reader: The reader to initialize.
+ *   - file_name: The name of the file to open.
+ * Returns:
+ *   - NO_ERRORS if the file was opened, SYNTAX_OR_LOGIC_ERROR if it cannot be opened.
+ * Algorithm:
+ *   - Open the file and check with fstat that it is a regular file.
+ *   - Map the whole file read-only; an empty file is treated as an empty mapping.
+ *   - If the file is not regular or the mapping fails, keep a stdio stream as a fallback.
+ */
+
+int source_reader_open(SOURCE_READER *reader, char *file_name)
+{
+    int fd;
+    struct stat file_stat;
+    void *mapped;
+
+    reader->data = NULL;
+    reader->size = 0;
+    reader->pos = 0;
+    reader->fallback = NULL;
+
+    fd = open(file_name, O_RDONLY);
+    if (fd == -1)
+    {
+        return SYNTAX_OR_LOGIC_ERROR;
+    }
+
+    if ((fstat(fd, &file_stat) == 0) && (S_ISREG(file_stat.st_mode)))
+    {
+        if (file_stat.st_size == 0)
+        {
+            /*mmap cannot map zero bytes, an empty file is simply an empty source*/
+            close(fd);
+            reader->data = "";
+            return NO_ERRORS;
+        }
+
+        mapped = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        /*The mapping keeps the content available after the descriptor is closed*/
+        close(fd);
+
+        if (mapped != MAP_FAILED)
+        {
+            reader->data = (char *)mapped;
+            reader->size = (long)file_stat.st_size;
+            return NO_ERRORS;
+        }
+    }
+
+    else
+    {
+        close(fd);
+    }
+
+    /*The input is not a regular file or the mapping failed - fall back to the stdio path*/
+    reader->fallback = fopen(file_name, "r");
+    if (reader->fallback == NULL)
+    {
+        return SYNTAX_OR_LOGIC_ERROR;
+    }
+
+    return NO_ERRORS;
+}
+
+/*
+ * Function: source_reader_gets
+ * -----------------------------
+ * Description:
+ *   Reads the next line from the source, mirroring the behavior of fgets.
+ * Parameters:
+ *   - reader: The reader to read from.
+ *   - dest: The destination array into which the line is copied.
+ *   - max_len: The size of the destination array.
+ * Returns:
+ *   - dest if a line was read, or NULL if the end of the source was reached.
+ * Algorithm:
+ *   - On the fallback path, delegate to fgets.
+ *   - On the mapped path, locate the line span from the current position to the next
+ *     newline and copy at most max_len - 1 characters of it (the newline is kept, as
+ *     in fgets, so the existing line length checks behave the same).
+ */
+
+char *source_reader_gets(SOURCE_READER *reader, char *dest, int max_len)
+{
+    int copied = 0;
+
+    if (reader->fallback != NULL)
+    {
+        return fgets(dest, max_len, reader->fallback);
+    }
+
+    if (reader->pos >= reader->size)
+    {
+        return NULL;
+    }
+
+    while ((reader->pos < reader->size) && (copied < max_len - 1))
+    {
+        dest[copied] = reader->data[reader->pos];
+        reader->pos++;
+        copied++;
+
+        if (reader->data[reader->pos - 1] == '\n')
+        {
+            break;
+        }
+    }
+
+    dest[copied] = '\0';
+    return dest;
+}
+
+/*
+ * Function: source_reader_close
+ * ------------------------------
+ * Description:
+ *   Releases the mapping or closes the fallback stream held by the reader.
+ * Parameters:
+ *   - reader: The reader to close.
+ */
+
+void source_reader_close(SOURCE_READER *reader)
+{
+    if (reader->fallback != NULL)
+    {
+        fclose(reader->fallback);
+        reader->fallback = NULL;
+    }
+
+    else if (reader->size > 0)
+    {
+        munmap(reader->data, (size_t)reader->size);
+    }
+
+    reader->data = NULL;
+    reader->size = 0;
+    reader->pos = 0;
+}
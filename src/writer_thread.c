@@ -0,0 +1,317 @@
+/*
+ * File: writer_thread.c
+ * ---------------------
+ * Description:
+ *   This file implements the background output writer. Assembling a file ends with
+ *   writing its .ob, .ent and .ext files, and doing that on the assembling thread makes
+ *   the CPU-bound parsing of the next file wait on the disk. Instead, a finished
+ *   translation unit is packed into an OUTPUT_JOB and pushed into a small bounded queue;
+ *   a single writer thread pops the jobs, emits the three files, stores the outputs in
+ *   the incremental cache and releases the memory of the file. The queue follows the
+ *   ring of pipeline.c: a mutex with two condition variables, blocking the producers
+ *   while the queue is full and the writer while it is empty. Diagnostics of failed
+ *   writes are printed by the writer with single stdio calls, so they are not torn by
+ *   the messages of the assembling threads.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "include/writer_thread.h"
+#include "include/general.h"
+#include "include/back_end.h"
+#include "include/cache.h"
+#include "include/profile.h"
+#include "include/arena.h"
+
+/*The queue between the assembling threads and the writer thread*/
+static OUTPUT_JOB queue_jobs[WRITER_QUEUE_CAPACITY];
+static int queue_head = 0;
+static int queue_tail = 0;
+static int queue_count = 0;
+static int queue_done = 0;
+static int queue_busy = 0; /*Set while the writer is flushing a popped job, for writer_thread_drain*/
+
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_not_full = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queue_idle = PTHREAD_COND_INITIALIZER;
+
+static pthread_t writer_thread;
+static int writer_running = 0;
+
+/*Sticky failure flag of the flushes since the last drain, guarded by queue_lock. The
+  server folds it into the status line, so a request is never answered with result=ok
+  when one of its output files could not be written*/
+static int flush_failed = 0;
+
+/*
+ * Function: flush_job
+ * --------------------
+ * Description:
+ *   Emits the output files of one finished translation unit: the object file in the
+ *   selected format, the entries and externals files when they are not empty, and the
+ *   cache entry when the cache is enabled. Afterwards the memory of the file is
+ *   released, including its arena. With --profile the per-file line is printed here,
+ *   so the back-end time covers the actual writes.
+ *
+ * Parameters:
+ *   - job: The output job to flush.
+ *
+ * Returns:
+ *   - NO_ERRORS when every output file was written, MEMORY_ALLOCATION_ERROR when one
+ *     of them could not be created. The error was already printed; the callers fold
+ *     the status into flush_failed for writer_thread_drain.
+ */
+
+static int flush_job(OUTPUT_JOB *job)
+{
+    double stage_stamp = 0.0;
+    double back_seconds = 0.0;
+    int result = NO_ERRORS;
+
+    /*The path strings the back end and the cache build with dynamic_strcat are drawn
+      from the current arena; without one on this thread they would silently fall back
+      to malloc and leak. The arena of the job is released below anyway, so it is
+      installed for the duration of the flush*/
+    arena_set_current(&job->arena);
+
+    if (profile_enabled)
+    {
+        stage_stamp = profile_seconds_now();
+    }
+
+    /*create the object file, using the translation unit*/
+    if ((job->binary_obj_flag ? create_binary_object_file(&job->unit, job->file_name)
+                              : create_object_file(&job->unit, job->file_name)) != MEMORY_ALLOCATION_ERROR)
+    {
+        /*There is no memory or file opening error in the creation of the ob file*/
+        if (job->unit.entries_counter > 0 &&
+            create_entries_file(&job->unit, job->file_name) == MEMORY_ALLOCATION_ERROR)
+        {
+            result = MEMORY_ALLOCATION_ERROR;
+        }
+
+        if (job->unit.external_counter > 0 &&
+            create_external_file(&job->unit, job->file_name) == MEMORY_ALLOCATION_ERROR)
+        {
+            result = MEMORY_ALLOCATION_ERROR;
+        }
+
+        /*The outputs exist now, so the next run with the same content is a hit; a
+          partial flush is not stored, or a later hit would restore incomplete outputs*/
+        if (result == NO_ERRORS && job->cache_dir != NULL)
+        {
+            cache_store(job->cache_dir, job->content_key, job->file_name);
+        }
+    }
+
+    else
+    {
+        result = MEMORY_ALLOCATION_ERROR;
+    }
+
+    if (profile_enabled)
+    {
+        back_seconds = profile_seconds_now() - stage_stamp;
+        profile_record_file(job->file_name, job->pre_seconds, job->first_seconds,
+                            job->second_seconds, back_seconds,
+                            job->symbol_lookups, job->symbol_probes,
+                            job->macro_lookups, job->macro_probes);
+    }
+
+    /*The job owns the memory of the file from the handoff on; the names of the entries
+      and externals live in the arena, so it is released last*/
+    free_ext_refs(&job->unit);
+    free_entries(&job->unit);
+    free_memory_image(&job->unit.instruction_image);
+    free_memory_image(&job->unit.data_image);
+    arena_set_current(NULL);
+    arena_release(&job->arena);
+    return result;
+}
+
+/*
+ * Function: writer_main
+ * ----------------------
+ * Description:
+ *   Entry point of the writer thread. It pops jobs from the queue and flushes them
+ *   until the queue is marked as done and drained.
+ *
+ * Parameters:
+ *   - arg: Unused.
+ *
+ * Returns:
+ *   NULL.
+ */
+
+static void *writer_main(void *arg)
+{
+    OUTPUT_JOB job;
+    int result;
+    (void)arg;
+
+    while (1)
+    {
+        pthread_mutex_lock(&queue_lock);
+
+        while (queue_count == 0 && queue_done == 0)
+        {
+            pthread_cond_wait(&queue_not_empty, &queue_lock);
+        }
+
+        if (queue_count == 0)
+        {
+            pthread_mutex_unlock(&queue_lock);
+            return NULL;
+        }
+
+        job = queue_jobs[queue_head];
+        queue_head = (queue_head + 1) % WRITER_QUEUE_CAPACITY;
+        queue_count--;
+        queue_busy = 1;
+
+        pthread_cond_signal(&queue_not_full);
+        pthread_mutex_unlock(&queue_lock);
+
+        result = flush_job(&job);
+
+        pthread_mutex_lock(&queue_lock);
+        queue_busy = 0;
+
+        if (result != NO_ERRORS)
+        {
+            flush_failed = 1;
+        }
+
+        if (queue_count == 0)
+        {
+            pthread_cond_broadcast(&queue_idle);
+        }
+
+        pthread_mutex_unlock(&queue_lock);
+    }
+}
+
+/*
+ * Function: writer_thread_start
+ * ------------------------------
+ * Description:
+ *   Starts the background writer thread. When the start fails, submitted jobs are
+ *   flushed synchronously by the submitting thread instead.
+ *
+ * Returns:
+ *   - NO_ERRORS if the thread was started, SYNTAX_OR_LOGIC_ERROR otherwise.
+ */
+
+int writer_thread_start(void)
+{
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0)
+    {
+        return SYNTAX_OR_LOGIC_ERROR;
+    }
+
+    writer_running = 1;
+    return NO_ERRORS;
+}
+
+/*
+ * Function: writer_thread_submit
+ * -------------------------------
+ * Description:
+ *   Hands the output work of a finished file to the writer thread, blocking while the
+ *   queue is full. Without a running writer the job is flushed right here, so the
+ *   callers never need a fallback path of their own.
+ *
+ * Parameters:
+ *   - job: The output job to hand off.
+ */
+
+void writer_thread_submit(OUTPUT_JOB *job)
+{
+    if (writer_running == 0)
+    {
+        if (flush_job(job) != NO_ERRORS)
+        {
+            pthread_mutex_lock(&queue_lock);
+            flush_failed = 1;
+            pthread_mutex_unlock(&queue_lock);
+        }
+
+        return;
+    }
+
+    pthread_mutex_lock(&queue_lock);
+
+    while (queue_count == WRITER_QUEUE_CAPACITY)
+    {
+        pthread_cond_wait(&queue_not_full, &queue_lock);
+    }
+
+    queue_jobs[queue_tail] = *job;
+    queue_tail = (queue_tail + 1) % WRITER_QUEUE_CAPACITY;
+    queue_count++;
+
+    pthread_cond_signal(&queue_not_empty);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+/*
+ * Function: writer_thread_drain
+ * ------------------------------
+ * Description:
+ *   Blocks until every job submitted so far was flushed, without stopping the writer.
+ *   The server mode calls this before replying to a request, so the outputs of the
+ *   file are on disk when the client reads the status.
+ *
+ * Returns:
+ *   - NO_ERRORS when every flush since the previous drain succeeded, otherwise
+ *     SYNTAX_OR_LOGIC_ERROR; the flag is cleared for the next request.
+ */
+
+int writer_thread_drain(void)
+{
+    int failed;
+
+    pthread_mutex_lock(&queue_lock);
+
+    if (writer_running)
+    {
+        while (queue_count > 0 || queue_busy)
+        {
+            pthread_cond_wait(&queue_idle, &queue_lock);
+        }
+    }
+
+    failed = flush_failed;
+    flush_failed = 0;
+
+    pthread_mutex_unlock(&queue_lock);
+
+    return failed ? SYNTAX_OR_LOGIC_ERROR : NO_ERRORS;
+}
+
+/*
+ * Function: writer_thread_finish
+ * -------------------------------
+ * Description:
+ *   Waits until every submitted job was flushed and stops the writer thread. Called
+ *   once at the end of the run, so the process never exits with outputs still queued.
+ */
+
+void writer_thread_finish(void)
+{
+    if (writer_running == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&queue_lock);
+    queue_done = 1;
+    pthread_cond_broadcast(&queue_not_empty);
+    pthread_mutex_unlock(&queue_lock);
+
+    pthread_join(writer_thread, NULL);
+    writer_running = 0;
+}